@@ -0,0 +1,679 @@
+#include "h5.h"
+#include "h5_writer_service.h"
+#include "h5_sharded_writer.h"
+#include "h5_directory_reader.h"
+#include "h5_writer_factory.h"
+#include "h5_interpolator.h"
+
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+// Times every public H5FileWriter/H5FileReader operation across matrix sizes and
+// thread counts and prints the results as JSON on stdout.
+//
+// Usage: hdf5_multithread_test_benchmark [--dir <path>] [--sizes 8,16,24] [--threads <max>]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+    std::string operation;
+    std::string mode;
+    size_t size = 0;    // Edge length of the N^4 matrix
+    size_t threads = 1;
+    size_t ops = 0;
+    double seconds = 0.0;
+    double bytes = 0.0;
+    std::vector<double> latencies; // Nanoseconds per call
+};
+
+struct Options {
+    std::string directory = (std::filesystem::temp_directory_path() / "hdf5_benchmark").string();
+    std::vector<size_t> sizes = {8, 16, 24};
+    size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+};
+
+std::vector<Result> results;
+
+// Threaded sweeps call HDF5 from several threads. Without a thread safe library
+// they take this lock around every call instead, and their modes are suffixed
+// so results from the two setups are not compared.
+bool library_threadsafe = false;
+std::mutex library_mutex;
+
+std::unique_lock<std::mutex> libraryLock() {
+    if (library_threadsafe) {
+        return std::unique_lock<std::mutex>();
+    }
+    return std::unique_lock<std::mutex>(library_mutex);
+}
+
+std::string threadedMode(const std::string& mode) {
+    return library_threadsafe ? mode : mode + "_serialised";
+}
+
+// Writers announce every file on std::cout, which would corrupt the JSON. Writers
+// created on many threads announce concurrently, so the sink discards without
+// keeping any state to race on or grow.
+class QuietStdout {
+    public:
+        QuietStdout() : previous(std::cout.rdbuf(&sink)) {}
+        ~QuietStdout() { std::cout.rdbuf(previous); }
+    private:
+        struct DiscardBuffer : std::streambuf {
+            int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+            std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+        };
+        DiscardBuffer sink;
+        std::streambuf* previous;
+};
+
+// Time ops calls of fn(n) individually
+template <typename F>
+Result measure(const std::string& operation, const std::string& mode, size_t size, size_t ops, double bytes_per_op, F&& fn) {
+    Result result;
+    result.operation = operation;
+    result.mode = mode;
+    result.size = size;
+    result.ops = ops;
+    result.bytes = bytes_per_op * ops;
+    result.latencies.reserve(ops);
+
+    auto start = Clock::now();
+    for (size_t n = 0; n < ops; ++n) {
+        auto before = Clock::now();
+        fn(n);
+        result.latencies.push_back(std::chrono::duration<double, std::nano>(Clock::now() - before).count());
+    }
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return result;
+}
+
+// Run fn(thread, n) for ops_per_thread calls on each of threads threads
+template <typename F>
+Result measureThreads(const std::string& operation, const std::string& mode, size_t size, size_t threads, size_t ops_per_thread, double bytes_per_op, F&& fn) {
+    Result result;
+    result.operation = operation;
+    result.mode = mode;
+    result.size = size;
+    result.threads = threads;
+    result.ops = threads * ops_per_thread;
+    result.bytes = bytes_per_op * result.ops;
+
+    std::vector<std::vector<double>> latencies(threads);
+    std::vector<std::future<void>> futures;
+    auto start = Clock::now();
+    for (size_t t = 0; t < threads; ++t) {
+        futures.push_back(std::async(std::launch::async, [&, t]() {
+            latencies[t].reserve(ops_per_thread);
+            for (size_t n = 0; n < ops_per_thread; ++n) {
+                auto before = Clock::now();
+                fn(t, n);
+                latencies[t].push_back(std::chrono::duration<double, std::nano>(Clock::now() - before).count());
+            }
+        }));
+    }
+    for (auto& f : futures) {
+        f.get();
+    }
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    for (auto& thread_latencies : latencies) {
+        result.latencies.insert(result.latencies.end(), thread_latencies.begin(), thread_latencies.end());
+    }
+    return result;
+}
+
+double percentile(std::vector<double>& values, double fraction) {
+    if (values.empty()) return 0.0;
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+void writeJson(std::ostream& out) {
+    out << "[\n";
+    for (size_t n = 0; n < results.size(); ++n) {
+        Result& r = results[n];
+        double seconds = std::max(r.seconds, 1e-12);
+        out << "  {\"operation\": \"" << r.operation << "\", \"mode\": \"" << r.mode << "\""
+            << ", \"size\": " << r.size << ", \"threads\": " << r.threads << ", \"ops\": " << r.ops
+            << ", \"seconds\": " << r.seconds << ", \"ops_per_s\": " << r.ops / seconds
+            << ", \"mb_per_s\": " << r.bytes / seconds / 1e6
+            << ", \"p50_us\": " << percentile(r.latencies, 0.50) / 1e3
+            << ", \"p99_us\": " << percentile(r.latencies, 0.99) / 1e3 << "}"
+            << (n + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "]" << std::endl;
+}
+
+// Path of the most recently created file with the given prefix
+std::string newestFile(const std::string& directory, const std::string& prefix) {
+    std::string newest;
+    std::filesystem::file_time_type newest_time;
+    for (auto& item : std::filesystem::directory_iterator(directory)) {
+        std::string name = item.path().filename().string();
+        if (name.rfind(prefix + "___", 0) == 0 && (newest.empty() || item.last_write_time() > newest_time)) {
+            newest = item.path().string();
+            newest_time = item.last_write_time();
+        }
+    }
+    return newest;
+}
+
+double pointValue(size_t i, size_t j, size_t k, size_t l) {
+    return std::sin(0.1 * i + 0.2 * j + 0.3 * k + 0.4 * l);
+}
+
+// Unravel a linear index of an n^4 matrix
+void unravel(size_t index, size_t n, int* coords) {
+    for (int d = 3; d >= 0; --d) {
+        coords[d] = static_cast<int>(index % n);
+        index /= n;
+    }
+}
+
+void benchmarkWriter(Options& options, size_t n) {
+    std::string prefix = "bench_write";
+    const size_t elements = n * n * n * n;
+    const double matrix_bytes = elements * sizeof(double);
+    const size_t direct_ops = std::min<size_t>(elements, 20000);
+    H5FileWriter writer(options.directory, prefix);
+
+    results.push_back(measure("writeScalarToDataset", "default", n, 1000, sizeof(double), [&](size_t op) {
+        writer.writeScalarToDataset("scalar_" + std::to_string(op), 1.0 * op);
+    }));
+
+    std::map<std::string, double> dictionary;
+    for (int key = 0; key < 50; ++key) dictionary["key" + std::to_string(key)] = key;
+    results.push_back(measure("writeDictionaryOfScalarsToDataset", "datasets", n, 20, 50 * sizeof(double), [&](size_t op) {
+        writer.writeDictionaryOfScalarsToDataset("dictionary_" + std::to_string(op), dictionary);
+    }));
+    results.push_back(measure("writeDictionaryOfScalarsToDataset", "table", n, 20, 50 * sizeof(double), [&](size_t op) {
+        writer.writeDictionaryOfScalarsToDataset("table_" + std::to_string(op), dictionary, DictionaryStorage::Table);
+    }));
+
+    std::vector<double> axis(n);
+    for (size_t i = 0; i < n; ++i) axis[i] = 0.5 * i;
+    results.push_back(measure("writeMatrixAxisToDataset", "default", n, 100, n * sizeof(double), [&](size_t op) {
+        writer.writeMatrixAxisToDataset("axis_" + std::to_string(op), axis);
+    }));
+
+    std::vector<hid_t> contiguous, chunked, compressed;
+    results.push_back(measure("generate4DMatrix", "contiguous", n, 4, matrix_bytes, [&](size_t op) {
+        contiguous.push_back(writer.generate4DMatrix("contiguous_" + std::to_string(op), n, n, n, n));
+    }));
+    MatrixOptions chunked_options;
+    chunked_options.chunked = true;
+    results.push_back(measure("generate4DMatrix", "chunked", n, 4, matrix_bytes, [&](size_t op) {
+        chunked.push_back(writer.generate4DMatrix("chunked_" + std::to_string(op), n, n, n, n, chunked_options));
+    }));
+    MatrixOptions compressed_options;
+    compressed_options.compression_level = 4;
+    results.push_back(measure("generate4DMatrix", "compressed", n, 1, matrix_bytes, [&](size_t op) {
+        compressed.push_back(writer.generate4DMatrix("compressed_" + std::to_string(op), n, n, n, n, compressed_options));
+    }));
+    hid_t five = -1;
+    const size_t n5 = std::min<size_t>(n, 12);
+    results.push_back(measure("generate5DMatrix", "contiguous", n5, 1, matrix_bytes * n5 / n, [&](size_t) {
+        five = writer.generate5DMatrix("five", n5, n5, n5, n5, n5);
+    }));
+
+    int c[4];
+    results.push_back(measure("writeTo4DMatrix", "direct", n, direct_ops, sizeof(double), [&](size_t op) {
+        unravel(op, n, c);
+        writer.writeTo4DMatrix(contiguous[0], pointValue(c[0], c[1], c[2], c[3]), c[0], c[1], c[2], c[3]);
+    }));
+    Matrix<4> handle = writer.generateMatrix<4>("handle", {n, n, n, n});
+    results.push_back(measure("Matrix::write", "direct", n, direct_ops, sizeof(double), [&](size_t op) {
+        unravel(op, n, c);
+        handle.write(pointValue(c[0], c[1], c[2], c[3]), c[0], c[1], c[2], c[3]);
+    }));
+    results.push_back(measure("writeTo5DMatrix", "direct", n5, std::min<size_t>(direct_ops, n5 * n5 * n5 * n5 * n5), sizeof(double), [&](size_t op) {
+        writer.writeTo5DMatrix(five, 1.0 * op, 0, op / (n5 * n5 * n5) % n5, op / (n5 * n5) % n5, op / n5 % n5, op % n5);
+    }));
+
+    std::vector<double> values(elements);
+    std::vector<hsize_t> coords(elements * 4);
+    for (size_t op = 0; op < elements; ++op) {
+        unravel(op, n, c);
+        values[op] = pointValue(c[0], c[1], c[2], c[3]);
+        for (int d = 0; d < 4; ++d) coords[op * 4 + d] = c[d];
+    }
+    results.push_back(measure("writePointsTo4DMatrix", "batch", n, 1, matrix_bytes, [&](size_t) {
+        writer.writePointsTo4DMatrix(contiguous[1], values, coords);
+    }));
+
+    // Rows of unknown count appended to a matrix that starts empty
+    MatrixOptions unlimited_options;
+    unlimited_options.unlimited_axes = {0};
+    hid_t appended = writer.generate4DMatrix("appended", 0, n, n, n, unlimited_options);
+    std::vector<double> slab(values.begin(), values.begin() + n * n * n);
+    results.push_back(measure("appendSlab", "axis_0", n, n, slab.size() * sizeof(double), [&](size_t) {
+        writer.appendSlab(appended, 0, slab);
+    }));
+
+    // [i, j, :, :] blocks computed and then written, waiting on each write or double buffered
+    const size_t block_elements = n * n;
+    auto computeBlock = [&](std::vector<double>& block, size_t op) {
+        for (size_t e = 0; e < block_elements; ++e) block[e] = pointValue(op / n, op % n, e / n, e % n);
+    };
+    results.push_back(measure("writeBlockAsync", "wait_each", n, n * n, block_elements * sizeof(double), [&](size_t op) {
+        std::vector<double> block(block_elements);
+        computeBlock(block, op);
+        writer.writeBlockAsync(contiguous[3], {op / n, op % n, 0, 0}, {1, 1, n, n}, std::move(block)).get();
+    }));
+    {
+        std::future<std::vector<double>> in_flight[2];
+        Result result = measure("writeBlockAsync", "double_buffered", n, n * n, block_elements * sizeof(double), [&](size_t op) {
+            std::future<std::vector<double>>& slot = in_flight[op % 2];
+            std::vector<double> block = slot.valid() ? slot.get() : std::vector<double>(block_elements);
+            computeBlock(block, op);
+            slot = writer.writeBlockAsync(contiguous[3], {op / n, op % n, 0, 0}, {1, 1, n, n}, std::move(block));
+        });
+        auto start = Clock::now();
+        writer.drain();
+        result.seconds += std::chrono::duration<double>(Clock::now() - start).count();
+        results.push_back(std::move(result));
+    }
+
+    writer.enableBufferedWrites();
+    auto sweep = [&](const std::string& mode, hid_t dataset) {
+        Result result = measure("writeTo4DMatrix", mode, n, elements, sizeof(double), [&](size_t op) {
+            unravel(op, n, c);
+            writer.writeTo4DMatrix(dataset, values[op], c[0], c[1], c[2], c[3]);
+        });
+        auto start = Clock::now();
+        writer.flush();
+        result.seconds += std::chrono::duration<double>(Clock::now() - start).count();
+        results.push_back(std::move(result));
+    };
+    sweep("buffered", contiguous[2]);
+    sweep("chunked_buffered", chunked[0]);
+    sweep("compressed_buffered", compressed[0]);
+
+    // Reduced precision storage; values lie in [-1, 1]
+    MatrixOptions float32_options;
+    float32_options.storage = StorageType::Float32;
+    MatrixOptions int16_options;
+    int16_options.storage = StorageType::ScaledInt16;
+    int16_options.scale = 1.0 / 32000;
+    sweep("float32_buffered", writer.generate4DMatrix("float32", n, n, n, n, float32_options));
+    sweep("scaled_int16_buffered", writer.generate4DMatrix("scaled_int16", n, n, n, n, int16_options));
+
+    // Same sweep while live readers could follow along, flushing every 100 ms
+    writer.startLiveProgress(std::chrono::milliseconds(100));
+    sweep("buffered_live", contiguous[2]);
+}
+
+void benchmarkReader(Options& options, size_t n) {
+    std::string prefix = "bench_read";
+    const size_t elements = n * n * n * n;
+    {
+        H5FileWriter writer(options.directory, prefix);
+        writer.enableBufferedWrites();
+        MatrixOptions chunked_options;
+        chunked_options.chunked = true;
+        hid_t contiguous = writer.generate4DMatrix("contiguous", n, n, n, n);
+        hid_t chunked = writer.generate4DMatrix("chunked", n, n, n, n, chunked_options);
+        MatrixOptions tuned_options;
+        tuned_options.access.write_order = {0, 1, 2, 3};
+        tuned_options.access.slice_axes = {{0, 1}};
+        hid_t tuned = writer.generate4DMatrix("tuned", n, n, n, n, tuned_options);
+        int c[4];
+        for (size_t op = 0; op < elements; ++op) {
+            unravel(op, n, c);
+            writer.writeTo4DMatrix(contiguous, pointValue(c[0], c[1], c[2], c[3]), c[0], c[1], c[2], c[3]);
+            writer.writeTo4DMatrix(chunked, pointValue(c[0], c[1], c[2], c[3]), c[0], c[1], c[2], c[3]);
+            writer.writeTo4DMatrix(tuned, pointValue(c[0], c[1], c[2], c[3]), c[0], c[1], c[2], c[3]);
+        }
+        std::vector<double> axis(n, 1.0);
+        writer.writeMatrixAxisToDataset("axis", axis);
+        std::vector<double> grid(n);
+        for (size_t i = 0; i < n; ++i) grid[i] = 0.5 * i;
+        writer.writeMatrixAxisToDataset("grid", grid);
+        writer.writeScalarToDataset("scalar", 1.0);
+        std::map<std::string, double> dictionary;
+        for (int key = 0; key < 50; ++key) dictionary["key" + std::to_string(key)] = key;
+        writer.writeDictionaryOfScalarsToDataset("dictionary", dictionary);
+        writer.writeDictionaryOfScalarsToDataset("table", dictionary, DictionaryStorage::Table);
+    }
+    std::string path = newestFile(options.directory, prefix);
+    H5FileReader reader(path);
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> pick(0, static_cast<int>(n) - 1);
+    const size_t point_ops = 20000;
+
+    results.push_back(measure("readScalarFromDataset", "default", n, point_ops, sizeof(double), [&](size_t) {
+        reader.readScalarFromDataset("scalar");
+    }));
+    for (const char* name : {"dictionary", "table"}) {
+        results.push_back(measure("readDictionaryFromDataset", name, n, 1, 50 * sizeof(double), [&](size_t) {
+            reader.readDictionaryFromDataset(name);
+        }));
+    }
+    results.push_back(measure("readScalarFromDictionary", "cached", n, point_ops, sizeof(double), [&](size_t op) {
+        reader.readScalarFromDictionary("table", "key" + std::to_string(op % 50));
+    }));
+    results.push_back(measure("readMatrixAxisFromDataset", "default", n, point_ops, n * sizeof(double), [&](size_t) {
+        reader.readMatrixAxisFromDataset("axis");
+    }));
+    results.push_back(measure("readPointFromVector", "default", n, point_ops, sizeof(double), [&](size_t) {
+        reader.readPointFromVector("axis", pick(gen));
+    }));
+
+    for (const char* mode : {"mapped", "hdf5"}) {
+        reader.setMemoryMapping(std::string(mode) == "mapped");
+        results.push_back(measure("readPointFromMatrix", mode, n, point_ops, sizeof(double), [&](size_t) {
+            reader.readPointFromMatrix("contiguous", pick(gen), pick(gen), pick(gen), pick(gen));
+        }));
+    }
+    reader.setMemoryMapping(false);
+    {
+        Matrix<4> handle = reader.openMatrix<4>("contiguous");
+        results.push_back(measure("Matrix::read", "hdf5", n, point_ops, sizeof(double), [&](size_t) {
+            handle.read(pick(gen), pick(gen), pick(gen), pick(gen));
+        }));
+    }
+    reader.setMemoryMapping(true);
+    results.push_back(measure("readPointFromMatrix", "chunked", n, point_ops, sizeof(double), [&](size_t) {
+        reader.readPointFromMatrix("chunked", pick(gen), pick(gen), pick(gen), pick(gen));
+    }));
+
+    const size_t batch = 10000;
+    std::vector<hsize_t> coords(batch * 4);
+    for (auto& coordinate : coords) coordinate = pick(gen);
+    results.push_back(measure("readPointsFromMatrix", "chunked", n, 10, batch * sizeof(double), [&](size_t) {
+        reader.readPointsFromMatrix("chunked", coords);
+    }));
+
+    // Quadrilinear lookups at physical coordinates: axes searched and 16 corners read by hand, or batched
+    std::uniform_real_distribution<double> position(0.0, 0.5 * (n - 1));
+    std::vector<double> queries(batch * 4);
+    for (auto& query : queries) query = position(gen);
+    const std::vector<double> grid = reader.readMatrixAxisFromDataset("grid");
+    double interpolated = 0.0;
+    results.push_back(measure("interpolate", "point_reads", n, 1000, sizeof(double), [&](size_t op) {
+        const double* query = &queries[op * 4];
+        int lower[4];
+        double weight[4];
+        for (int d = 0; d < 4; ++d) {
+            lower[d] = static_cast<int>(std::min<size_t>(std::upper_bound(grid.begin(), grid.end(), query[d]) - grid.begin(), n - 1)) - 1;
+            weight[d] = (query[d] - grid[lower[d]]) / (grid[lower[d] + 1] - grid[lower[d]]);
+        }
+        for (int corner = 0; corner < 16; ++corner) {
+            int c[4];
+            double product = 1.0;
+            for (int d = 0; d < 4; ++d) {
+                const bool upper = (corner >> d) & 1;
+                c[d] = lower[d] + upper;
+                product *= upper ? weight[d] : 1.0 - weight[d];
+            }
+            interpolated += product * reader.readPointFromMatrix("chunked", c[0], c[1], c[2], c[3]);
+        }
+    }));
+    H5Interpolator interpolator(reader, "chunked", {"grid", "grid", "grid", "grid"});
+    results.push_back(measure("H5Interpolator::interpolate", "batch", n, 10, batch * sizeof(double), [&](size_t) {
+        interpolator.interpolate(queries, batch);
+    }));
+    reader.setBlockCache(&H5BlockCache::shared());
+    results.push_back(measure("H5Interpolator::interpolate", "batch_block_cache", n, 10, batch * sizeof(double), [&](size_t) {
+        interpolator.interpolate(queries, batch);
+    }));
+    reader.setBlockCache(nullptr);
+
+    const double slice_bytes = n * n * sizeof(double);
+    for (const char* name : {"contiguous", "chunked", "tuned"}) {
+        results.push_back(measure("read2DSliceFromMatrix", name, n, 200, slice_bytes, [&](size_t) {
+            reader.read2DSliceFromMatrix(name, pick(gen), pick(gen));
+        }));
+        std::vector<double> slice;
+        results.push_back(measure("readSlice", name, n, 200, slice_bytes, [&](size_t) {
+            reader.readSlice(name, {0, 1}, {0, 0, static_cast<hsize_t>(pick(gen)), static_cast<hsize_t>(pick(gen))}, slice);
+        }));
+        results.push_back(measure("getMinimumFromMatrix", name, n, 5, elements * sizeof(double), [&](size_t) {
+            reader.getMinimumFromMatrix(name);
+        }));
+        results.push_back(measure("reduceMatrix", name, n, 5, elements * sizeof(double), [&](size_t) {
+            reader.reduceMatrix(name);
+        }));
+    }
+
+    // Short-lived result file written and read straight back, on disk or as a file image
+    std::string round_trip_prefix = "bench_round_trip";
+    std::vector<double> axis(n, 1.0);
+    for (WriterStorage storage : {WriterStorage::Disk, WriterStorage::Memory}) {
+        const char* mode = storage == WriterStorage::Disk ? "disk" : "memory";
+        results.push_back(measure("writeThenRead", mode, n, 20, n * sizeof(double), [&](size_t) {
+            std::string path;
+            std::vector<unsigned char> image;
+            {
+                H5FileWriter writer(options.directory, round_trip_prefix, storage);
+                writer.writeScalarToDataset("scalar", 1.0);
+                writer.writeMatrixAxisToDataset("axis", axis);
+                if (storage == WriterStorage::Memory) image = writer.fileImage();
+                path = writer.getFilePath();
+            }
+            if (storage == WriterStorage::Disk) {
+                H5FileReader reader(path);
+                reader.readMatrixAxisFromDataset("axis");
+                std::filesystem::remove(path);
+            } else {
+                H5FileReader reader(std::move(image));
+                reader.readMatrixAxisFromDataset("axis");
+            }
+        }));
+    }
+}
+
+void benchmarkThreads(Options& options, size_t n) {
+    const size_t elements = n * n * n * n;
+    std::vector<size_t> thread_counts;
+    for (size_t t = 1; t < options.max_threads; t *= 2) thread_counts.push_back(t);
+    thread_counts.push_back(options.max_threads);
+
+    for (size_t threads : thread_counts) {
+        // Every thread fills its own file, as multiThreadedWrite does
+        std::string prefix = "bench_threads";
+        std::vector<std::unique_ptr<H5FileWriter>> writers;
+        std::vector<hid_t> matrices;
+        for (size_t t = 0; t < threads; ++t) {
+            writers.push_back(std::make_unique<H5FileWriter>(options.directory, prefix));
+            writers.back()->enableBufferedWrites();
+            matrices.push_back(writers.back()->generate4DMatrix("matrix", n, n, n, n));
+        }
+        results.push_back(measureThreads("writeTo4DMatrix", threadedMode("file_per_thread"), n, threads, elements, sizeof(double), [&](size_t t, size_t op) {
+            auto lock = libraryLock();
+            int c[4];
+            unravel(op, n, c);
+            writers[t]->writeTo4DMatrix(matrices[t], 1.0, c[0], c[1], c[2], c[3]);
+        }));
+        writers.clear();
+
+        // All threads feed one service
+        {
+            std::string service_prefix = "bench_service";
+            H5WriterService service(options.directory, service_prefix);
+            hid_t matrix = service.generate4DMatrix("matrix", threads, n, n, n).get();
+            const size_t per_thread = n * n * n;
+            Result result = measureThreads("H5WriterService::writeTo4DMatrix", "service", n, threads, per_thread, sizeof(double), [&](size_t t, size_t op) {
+                service.writeTo4DMatrix(matrix, 1.0, static_cast<int>(t), static_cast<int>(op / (n * n)), static_cast<int>(op / n % n), static_cast<int>(op % n));
+            });
+            auto start = Clock::now();
+            service.flush().get();
+            result.seconds += std::chrono::duration<double>(Clock::now() - start).count();
+            results.push_back(std::move(result));
+        }
+
+        // Every thread fills its own shard of one matrix; shards serialise themselves without a thread safe library
+        {
+            std::string sharded_prefix = "bench_sharded";
+            H5ShardedWriter sharded(options.directory, sharded_prefix, threads);
+            sharded.generate4DMatrix("matrix", threads * n, n, n, n);
+            sharded.enableBufferedWrites();
+            const size_t per_thread = n * n * n * n;
+            Result result = measureThreads("H5ShardedWriter::writeTo4DMatrix", threadedMode("sharded"), n, threads, per_thread, sizeof(double), [&](size_t t, size_t op) {
+                int c[4];
+                unravel(op, n, c);
+                H5ShardedWriter::Shard& shard = sharded.shard(t);
+                shard.writeTo4DMatrix(shard.dataset("matrix"), 1.0, static_cast<int>(t * n) + c[0], c[1], c[2], c[3]);
+            });
+            auto start = Clock::now();
+            sharded.close();
+            result.seconds += std::chrono::duration<double>(Clock::now() - start).count();
+            results.push_back(std::move(result));
+        }
+    }
+
+    // Readers share one H5FileReader
+    std::string prefix = "bench_shared";
+    {
+        H5FileWriter writer(options.directory, prefix);
+        writer.generate4DMatrix("contiguous", n, n, n, n);
+        MatrixOptions chunked_options;
+        chunked_options.chunked = true;
+        hid_t chunked = writer.generate4DMatrix("chunked", n, n, n, n, chunked_options);
+        writer.writeTo4DMatrix(chunked, 1.0, 0, 0, 0, 0);
+    }
+    H5FileReader reader(newestFile(options.directory, prefix));
+
+    // Every thread opens its own reader, with and without the shared block cache
+    for (size_t threads : thread_counts) {
+        for (const char* mode : {"reader_per_thread", "reader_per_thread_block_cache"}) {
+            const bool cached = std::string(mode) == "reader_per_thread_block_cache";
+            H5BlockCache::shared().clear();
+            std::vector<std::unique_ptr<H5FileReader>> readers;
+            for (size_t t = 0; t < threads; ++t) {
+                readers.push_back(std::make_unique<H5FileReader>(newestFile(options.directory, prefix)));
+                if (cached) readers.back()->setBlockCache(&H5BlockCache::shared());
+            }
+            results.push_back(measureThreads("read2DSliceFromMatrix", threadedMode(mode), n, threads, 200, n * n * sizeof(double), [&](size_t t, size_t op) {
+                auto lock = libraryLock();
+                readers[t]->read2DSliceFromMatrix("chunked", (t + op) % n, op * 7 % n);
+            }));
+        }
+    }
+
+    for (size_t threads : thread_counts) {
+        for (const char* name : {"contiguous", "chunked"}) {
+            results.push_back(measureThreads("readPointFromMatrix", threadedMode(std::string("shared_reader_") + name), n, threads, 10000, sizeof(double), [&](size_t t, size_t op) {
+                auto lock = libraryLock();
+                reader.readPointFromMatrix(name, (t + op) % n, op / n % n, op % n, (op * 7) % n);
+            }));
+        }
+    }
+
+    // A campaign of result files gathered one by one and through the directory reader
+    const size_t campaign_files = 32;
+    std::string campaign_prefix = "bench_campaign_" + std::to_string(n);
+    for (size_t f = 0; f < campaign_files; ++f) {
+        H5FileWriter writer(options.directory, campaign_prefix);
+        writer.generate4DMatrix("matrix", n, n, n, n);
+    }
+    const double campaign_bytes = campaign_files * elements * sizeof(double);
+    H5DirectoryReader directory(options.directory, campaign_prefix, options.max_threads);
+    results.push_back(measure("stackMatrices", "file_by_file", n, 1, campaign_bytes, [&](size_t) {
+        std::vector<double> stacked(campaign_files * elements);
+        for (size_t f = 0; f < directory.files().size(); ++f) {
+            H5FileReader file(directory.files()[f]);
+            file.readMatrix("matrix", stacked.data() + f * elements);
+        }
+    }));
+    results.push_back(measure("stackMatrices", "directory_reader", n, 1, campaign_bytes, [&](size_t) {
+        directory.stackMatrices("matrix");
+    }));
+    results.push_back(measure("maximumMatrix", "directory_reader", n, 1, campaign_bytes, [&](size_t) {
+        directory.maximumMatrix("matrix");
+    }));
+
+    // Files opened at a high rate: each writer set up from scratch, or handed out by a factory
+    // that creates files inline or keeps a pool of them created ahead
+    const size_t files_per_thread = 50;
+    for (size_t threads : thread_counts) {
+        std::string constructor_prefix = "bench_open_" + std::to_string(n);
+        results.push_back(measureThreads("H5FileWriter", threadedMode("constructor"), n, threads, files_per_thread, 0, [&](size_t, size_t) {
+            auto lock = libraryLock();
+            H5FileWriter writer(options.directory, constructor_prefix);
+        }));
+        H5WriterFactory factory(options.directory, "bench_factory_" + std::to_string(n));
+        results.push_back(measureThreads("H5WriterFactory::create", threadedMode("inline"), n, threads, files_per_thread, 0, [&](size_t, size_t) {
+            auto lock = libraryLock();
+            factory.create();
+        }));
+        H5WriterFactory pooled(options.directory, "bench_pooled_" + std::to_string(n), 32);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100)); // Let the pool fill
+        results.push_back(measureThreads("H5WriterFactory::create", threadedMode("pooled"), n, threads, files_per_thread, 0, [&](size_t, size_t) {
+            auto lock = libraryLock();
+            pooled.create();
+        }));
+    }
+}
+
+Options parseArguments(int argc, char** argv) {
+    Options options;
+    for (int n = 1; n < argc; n += 2) {
+        std::string flag = argv[n];
+        if (n + 1 == argc) {
+            throw std::invalid_argument("Missing value for " + flag);
+        }
+        std::string value = argv[n + 1];
+        if (flag == "--dir") {
+            options.directory = value;
+        } else if (flag == "--sizes") {
+            options.sizes.clear();
+            std::stringstream list(value);
+            for (std::string item; std::getline(list, item, ',');) {
+                options.sizes.push_back(std::stoul(item));
+            }
+        } else if (flag == "--threads") {
+            options.max_threads = std::max<size_t>(1, std::stoul(value));
+        } else {
+            throw std::invalid_argument("Unknown argument: " + flag);
+        }
+    }
+    return options;
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    try {
+        options = parseArguments(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << "Usage: " << argv[0] << " [--dir <path>] [--sizes 8,16,24] [--threads <max>]" << std::endl;
+        return 1;
+    }
+
+    // Start from an empty scratch directory
+    std::filesystem::path scratch = std::filesystem::path(options.directory) / "run";
+    std::filesystem::remove_all(scratch);
+    std::filesystem::create_directories(scratch);
+    options.directory = scratch.string();
+
+    hbool_t threadsafe = false;
+    library_threadsafe = H5is_library_threadsafe(&threadsafe) >= 0 && threadsafe;
+    if (!library_threadsafe) {
+        std::cerr << "HDF5 is not thread safe, threaded sweeps run serialised" << std::endl;
+    }
+
+    try {
+        QuietStdout quiet;
+        for (size_t n : options.sizes) {
+            std::cerr << "Benchmarking size " << n << std::endl;
+            benchmarkWriter(options, n);
+            benchmarkReader(options, n);
+            benchmarkThreads(options, n);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Benchmark failed: " << e.what() << std::endl;
+        return 1;
+    }
+
+    writeJson(std::cout);
+    std::filesystem::remove_all(scratch);
+    return 0;
+}
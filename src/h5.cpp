@@ -1,26 +1,240 @@
 
 #include "h5.h"
+#include "thread_pool.h"
+
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <future>
+
+#ifdef HDF5MT_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+// Pick a C-ordered block shape of at most max_elements: trailing dimensions are
+// kept whole for as long as they fit, leading dimensions are reduced to 1.
+std::vector<hsize_t> blockShape(const std::vector<hsize_t>& dims, size_t max_elements) {
+    std::vector<hsize_t> shape(dims.size(), 1);
+    hsize_t budget = std::max<hsize_t>(max_elements, 1);
+    for (size_t d = dims.size(); d-- > 0;) {
+        hsize_t extent = std::max<hsize_t>(dims[d], 1);
+        if (extent <= budget) {
+            shape[d] = extent;
+            budget /= extent;
+        } else {
+            shape[d] = budget;
+            break;
+        }
+    }
+    return shape;
+}
+
+// Validate a flat coordinate list against dims with one comparison per dimension
+void checkCoordinates(const hsize_t* coords, size_t count, const std::vector<hsize_t>& dims) {
+    const size_t rank = dims.size();
+    std::vector<hsize_t> highest(rank, 0);
+    for (size_t n = 0; n < count; ++n) {
+        for (size_t d = 0; d < rank; ++d) {
+            highest[d] = std::max(highest[d], coords[n * rank + d]);
+        }
+    }
+    for (size_t d = 0; count > 0 && d < rank; ++d) {
+        if (highest[d] >= dims[d]) {
+            throw std::out_of_range("Matrix indices are out of bounds");
+        }
+    }
+}
+
+#ifdef HDF5MT_HAVE_ZLIB
+// Same bytes the HDF5 shuffle and deflate filters produce for one chunk
+std::vector<unsigned char> shuffleAndDeflate(const std::vector<double>& values, int level) {
+    const size_t elements = values.size();
+    const size_t element_size = sizeof(double);
+    const unsigned char* source = reinterpret_cast<const unsigned char*>(values.data());
+
+    std::vector<unsigned char> shuffled(elements * element_size);
+    for (size_t byte = 0; byte < element_size; ++byte) {
+        unsigned char* plane = shuffled.data() + byte * elements;
+        for (size_t n = 0; n < elements; ++n) {
+            plane[n] = source[n * element_size + byte];
+        }
+    }
+
+    uLongf compressed_size = compressBound(static_cast<uLong>(shuffled.size()));
+    std::vector<unsigned char> compressed(compressed_size);
+    if (compress2(compressed.data(), &compressed_size, shuffled.data(), static_cast<uLong>(shuffled.size()), level) != Z_OK) {
+        throw std::runtime_error("Failed to deflate chunk.");
+    }
+    compressed.resize(compressed_size);
+    return compressed;
+}
+#endif
+
+struct BlockReduction {
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+    double sum = 0.0;
+    uint64_t finite = 0;
+    uint64_t nan = 0;
+    uint64_t ordered = 0; // Values other than NaN, infinities included, in min/max
+    size_t argmin = 0;
+    size_t argmax = 0;
+};
+
+// NaN-aware min/max/sum/count over data[begin, end). Min and max skip only NaN,
+// sum and the finite count skip infinities too. The value pass is branch free over
+// independent lanes so it vectorises; indices are found afterwards.
+BlockReduction reduceRange(const double* data, size_t begin, size_t end) {
+    constexpr int lanes = 4;
+    const double inf = std::numeric_limits<double>::infinity();
+    double lo[lanes], hi[lanes], sum[lanes];
+    uint64_t finite[lanes], nan[lanes];
+    for (int k = 0; k < lanes; ++k) {
+        lo[k] = inf;
+        hi[k] = -inf;
+        sum[k] = 0.0;
+        finite[k] = 0;
+        nan[k] = 0;
+    }
+
+    size_t i = begin;
+    for (; i + lanes <= end; i += lanes) {
+        for (int k = 0; k < lanes; ++k) {
+            double x = data[i + k];
+            bool is_finite = (x - x) == 0.0; // False for NaN and infinities
+            double low = x == x ? x : inf;
+            double high = x == x ? x : -inf;
+            lo[k] = low < lo[k] ? low : lo[k];
+            hi[k] = high > hi[k] ? high : hi[k];
+            sum[k] += is_finite ? x : 0.0;
+            finite[k] += is_finite;
+            nan[k] += x != x;
+        }
+    }
+    for (; i < end; ++i) {
+        double x = data[i];
+        if (x == x) {
+            lo[0] = std::min(lo[0], x);
+            hi[0] = std::max(hi[0], x);
+        }
+        if ((x - x) == 0.0) {
+            sum[0] += x;
+            finite[0]++;
+        }
+        nan[0] += x != x;
+    }
+
+    BlockReduction result;
+    for (int k = 0; k < lanes; ++k) {
+        result.min = std::min(result.min, lo[k]);
+        result.max = std::max(result.max, hi[k]);
+        result.sum += sum[k];
+        result.finite += finite[k];
+        result.nan += nan[k];
+    }
+
+    result.ordered = (end - begin) - result.nan;
+    if (result.ordered > 0) {
+        result.argmin = std::find(data + begin, data + end, result.min) - data;
+        result.argmax = std::find(data + begin, data + end, result.max) - data;
+    }
+    return result;
+}
+
+// Live writers keep {flush generation, flush time in ms since the epoch} here
+const char* const live_progress_name = "live_progress";
+
+// Growth step of in-memory files
+const size_t memory_increment = 64 << 10;
+
+// Values converted to the memory type of a storage type. Converted values live in a
+// per-thread buffer, valid until the next call on the same thread.
+const void* encodeValues(StorageType storage, const Quantisation& quantisation, const double* values, size_t count, hid_t& memory_type) {
+    if (storage == StorageType::Float32) {
+        thread_local std::vector<float> narrowed;
+        if (narrowed.size() < count) narrowed.resize(count);
+        for (size_t n = 0; n < count; ++n) narrowed[n] = static_cast<float>(values[n]);
+        memory_type = H5T_NATIVE_FLOAT;
+        return narrowed.data();
+    }
+    if (isScaled(storage)) {
+        thread_local std::vector<int32_t> codes;
+        if (codes.size() < count) codes.resize(count);
+        quantisation.encode(values, count, codes.data());
+        memory_type = H5T_NATIVE_INT32;
+        return codes.data();
+    }
+    memory_type = H5T_NATIVE_DOUBLE;
+    return values;
+}
+
+}
+
+void Quantisation::encode(const double* values, size_t count, int32_t* codes) const {
+    // Divide rather than multiply by 1 / scale, whose extra rounding can put 0.35 / 0.1 on a tie
+    const double lowest = nan_code + 1.0;
+    const double highest = -lowest;
+    for (size_t n = 0; n < count; ++n) {
+        const double value = values[n];
+        const double code = std::min(std::max(std::nearbyint((value - offset) / scale), lowest), highest);
+        codes[n] = value == value ? static_cast<int32_t>(code) : nan_code;
+    }
+}
+
+void Quantisation::decode(const int32_t* codes, size_t count, double* values) const {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    for (size_t n = 0; n < count; ++n) {
+        values[n] = codes[n] == nan_code ? nan : offset + scale * codes[n];
+    }
+}
+
+H5FileWriter::PropertyLists H5FileWriter::createPropertyLists(WriterStorage storage) {
+    PropertyLists lists;
+    lists[0] = H5Pcreate(H5P_FILE_CREATE);
+    lists[1] = H5Pcreate(H5P_FILE_ACCESS);
+    if (storage == WriterStorage::Disk) {
+        H5Pset_libver_bounds(lists[1], H5F_LIBVER_LATEST, H5F_LIBVER_LATEST);
+    } else {
+        // The core driver keeps the whole file in memory, a backing store is written on close.
+        // HDF5 1.10 copies newer superblocks into file images with a stale checksum, so
+        // in-memory files keep the original superblock format.
+        H5Pset_libver_bounds(lists[1], H5F_LIBVER_EARLIEST, H5F_LIBVER_LATEST);
+        H5Pset_fapl_core(lists[1], memory_increment, storage == WriterStorage::MemoryPersisted);
+    }
+
+    // Dataset property lists
+    lists[2] = H5Pcreate(H5P_DATASET_CREATE);
+    lists[3] = H5Pcreate(H5P_DATASET_ACCESS);
+    lists[4] = H5Pcreate(H5P_DATASET_XFER);
+    lists[5] = H5Pcreate(H5P_LINK_CREATE);
+    return lists;
+}
+
+H5FileWriter::H5FileWriter(std::string& directory, std::string& file_prefix, WriterStorage storage){
+    H5_STATS_OPERATION(H5Operation::Create, 0);
 
-H5FileWriter::H5FileWriter(std::string& directory, std::string& file_prefix){
     // Create property lists
-    fcpl = H5Pcreate(H5P_FILE_CREATE);
-    fapl = H5Pcreate(H5P_FILE_ACCESS);
-    H5Pset_libver_bounds(fapl, H5F_LIBVER_LATEST, H5F_LIBVER_LATEST);
-
-    // Create dataset property lists
-    dcpl = H5Pcreate(H5P_DATASET_CREATE);
-    dapl = H5Pcreate(H5P_DATASET_ACCESS);
-    dxpl = H5Pcreate(H5P_DATASET_XFER);
-    lcpl = H5Pcreate(H5P_LINK_CREATE);
+    this->storage = storage;
+    PropertyLists lists = createPropertyLists(storage);
+    fcpl = lists[0];
+    fapl = lists[1];
+    dcpl = lists[2];
+    dapl = lists[3];
+    dxpl = lists[4];
+    lcpl = lists[5];
     
     // Ensure the directory exists
-    if (!std::filesystem::exists(directory)) {
+    if (storage != WriterStorage::Memory && !std::filesystem::exists(directory)) {
         throw std::runtime_error("Directory does not exist: " + directory);
     }
 
     // Check if user has write permissions in directory
     std::error_code ec;
-    std::filesystem::permissions(directory, std::filesystem::perms::owner_all, ec);
+    if (storage != WriterStorage::Memory) {
+        std::filesystem::permissions(directory, std::filesystem::perms::owner_all, ec);
+    }
     if (ec) {
         throw std::runtime_error("No write permissions in directory: " + directory);
     }
@@ -29,16 +243,62 @@ H5FileWriter::H5FileWriter(std::string& directory, std::string& file_prefix){
     std::mt19937 gen(rd());
     std::uniform_int_distribution<> dis(1, 1000000);
     std::string file_path = directory + "/" + file_prefix + "___" + std::to_string(dis(gen)) + ".h5";
-    std::cout << "Generated file name: " << file_path << std::endl;
+    if (storage != WriterStorage::Memory) {
+        std::cout << "Generated file name: " << file_path << std::endl;
+    }
 
     this->file_path = file_path;
-    file = H5Fcreate(file_path.c_str(), H5F_ACC_TRUNC, fcpl, fapl);
+    file = H5_STATS_LIBRARY(H5Fcreate(file_path.c_str(), H5F_ACC_TRUNC, fcpl, fapl));
     if (file < 0) {
         throw std::runtime_error("Failed to create HDF5 file: " + file_path);
     }
 }
 
+H5FileWriter::H5FileWriter(hid_t file, const std::string& file_path, WriterStorage storage, const PropertyLists& property_lists)
+    : file(file), file_path(file_path), storage(storage) {
+    H5_STATS_OPERATION(H5Operation::Create, 0);
+
+    // Each writer holds a reference, the lists close with the last one
+    for (hid_t list : property_lists) H5Iinc_ref(list);
+    fcpl = property_lists[0];
+    fapl = property_lists[1];
+    dcpl = property_lists[2];
+    dapl = property_lists[3];
+    dxpl = property_lists[4];
+    lcpl = property_lists[5];
+}
+
 H5FileWriter::~H5FileWriter() {
+    if (live_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(live_mutex);
+            live_stopping = true;
+        }
+        live_stop.notify_all();
+        live_thread.join();
+    }
+
+    // Write out anything still staged, live readers get a last generation
+    try {
+        if (live_dataset >= 0) {
+            flushLiveProgress();
+        } else {
+            flush();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to flush staged writes to " << file_path << ": " << e.what() << std::endl;
+    }
+
+    // Block writes are drained by flush, the thread can go before the datasets close
+    if (block_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(block_mutex);
+            block_stopping = true;
+        }
+        block_submitted.notify_all();
+        block_thread.join();
+    }
+
     // Close datasets
     for (auto dataset : open_datasets) {
         H5Dclose(dataset);
@@ -53,138 +313,720 @@ H5FileWriter::~H5FileWriter() {
 }
 
 void H5FileWriter::writeScalarToDataset(const std::string& name, double value) {
+    H5_STATS_OPERATION(H5Operation::Write, sizeof(double));
+    requireNotLive(name);
+
     hsize_t dims[1] = {1};
     hid_t dataspace = H5Screate_simple(1, dims, nullptr);
     if (dataspace < 0) throw std::runtime_error("Failed to create dataspace for " + name);
 
-    hid_t dataset = H5Dcreate(file, name.c_str(), H5T_NATIVE_DOUBLE, dataspace, lcpl, dcpl, dapl);
+    hid_t dataset = H5_STATS_LIBRARY(H5Dcreate(file, name.c_str(), H5T_NATIVE_DOUBLE, dataspace, lcpl, dcpl, dapl));
     if (dataset < 0) throw std::runtime_error("Failed to create dataset: " + name);
 
-    H5Dwrite(dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, dxpl, &value);
+    H5_STATS_LIBRARY(H5Dwrite(dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, dxpl, &value));
     H5Dclose(dataset);
     H5Sclose(dataspace);
 };
 
-void H5FileWriter::writeDictionaryOfScalarsToDataset(const std::string& name, const std::map<std::string, double>& values) {
+void H5FileWriter::writeDictionaryOfScalarsToDataset(const std::string& name, const std::map<std::string, double>& values, DictionaryStorage storage) {
+    H5_STATS_OPERATION(H5Operation::Write, values.size() * sizeof(double));
+
+    if (storage == DictionaryStorage::Table) {
+        writeDictionaryTable(name, values);
+        return;
+    }
+
     for (auto& value : values) {
         writeScalarToDataset(name + "_" + value.first, value.second);
     }
 };
 
+void H5FileWriter::writeDictionaryTable(const std::string& name, const std::map<std::string, double>& values) {
+    requireNotLive(name);
+
+    // Rows are a fixed-length, null-terminated key followed by the value
+    size_t key_size = 1;
+    for (auto& value : values) {
+        key_size = std::max(key_size, value.first.size() + 1);
+    }
+    const size_t row_size = key_size + sizeof(double);
+
+    std::vector<char> rows(values.size() * row_size, '\0');
+    size_t row = 0;
+    for (auto& value : values) {
+        std::copy(value.first.begin(), value.first.end(), rows.begin() + row * row_size);
+        std::memcpy(rows.data() + row * row_size + key_size, &value.second, sizeof(double));
+        row++;
+    }
+
+    hid_t key_type = H5Tcopy(H5T_C_S1);
+    H5Tset_size(key_type, key_size);
+    H5Tset_strpad(key_type, H5T_STR_NULLTERM);
+    hid_t row_type = H5Tcreate(H5T_COMPOUND, row_size);
+    H5Tinsert(row_type, "key", 0, key_type);
+    H5Tinsert(row_type, "value", key_size, H5T_NATIVE_DOUBLE);
+    H5Tclose(key_type);
+
+    hsize_t dims[1] = {values.size()};
+    hid_t dataspace = H5Screate_simple(1, dims, nullptr);
+    if (dataspace < 0) {
+        H5Tclose(row_type);
+        throw std::runtime_error("Failed to create dataspace for " + name);
+    }
+
+    hid_t dataset = H5_STATS_LIBRARY(H5Dcreate(file, name.c_str(), row_type, dataspace, lcpl, dcpl, dapl));
+    if (dataset < 0) {
+        H5Sclose(dataspace);
+        H5Tclose(row_type);
+        throw std::runtime_error("Failed to create dataset: " + name);
+    }
+
+    herr_t status = values.empty() ? 0 : H5_STATS_LIBRARY(H5Dwrite(dataset, row_type, H5S_ALL, H5S_ALL, dxpl, rows.data()));
+    H5Dclose(dataset);
+    H5Sclose(dataspace);
+    H5Tclose(row_type);
+    if (status < 0) {
+        throw std::runtime_error("Failed to write dictionary table: " + name);
+    }
+}
+
 void H5FileWriter::writeMatrixAxisToDataset(const std::string& name, const std::vector<double>& axis) {
+    H5_STATS_OPERATION(H5Operation::Write, axis.size() * sizeof(double));
+    requireNotLive(name);
+
     hsize_t dims[1] = {axis.size()};
     hid_t dataspace = H5Screate_simple(1, dims, nullptr);
     if (dataspace < 0) throw std::runtime_error("Failed to create dataspace for " + name);
 
-    hid_t dataset = H5Dcreate(file, name.c_str(), H5T_NATIVE_DOUBLE, dataspace, lcpl, dcpl, dapl);
+    hid_t dataset = H5_STATS_LIBRARY(H5Dcreate(file, name.c_str(), H5T_NATIVE_DOUBLE, dataspace, lcpl, dcpl, dapl));
     if (dataset < 0) throw std::runtime_error("Failed to create dataset: " + name);
 
-    H5Dwrite(dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, dxpl, axis.data());
+    H5_STATS_LIBRARY(H5Dwrite(dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, dxpl, axis.data()));
     H5Dclose(dataset);
     H5Sclose(dataspace);
 };
 
-hid_t H5FileWriter::generate4DMatrix(const std::string& name, size_t N, size_t M, size_t O, size_t P) {
+hid_t H5FileWriter::generate4DMatrix(const std::string& name, size_t N, size_t M, size_t O, size_t P, const MatrixOptions& options) {
+    return createMatrix(name, {N, M, O, P}, options);
+}
+
+hid_t H5FileWriter::generate5DMatrix(const std::string& name, size_t N, size_t M, size_t O, size_t P, size_t Q, const MatrixOptions& options) {
+    return createMatrix(name, {N, M, O, P, Q}, options);
+}
+
+hid_t H5FileWriter::createMatrix(const std::string& name, const std::vector<hsize_t>& dims, const MatrixOptions& options, hid_t type) {
+    H5_STATS_OPERATION(H5Operation::Create, 0);
+    requireNotLive(name);
+    const int rank = static_cast<int>(dims.size());
+
+    // Resolve the chunk shape before touching the file
+    const bool chunked = options.chunked || options.compression_level > 0 || !options.access.empty() || !options.unlimited_axes.empty();
+    if (options.compression_level < 0 || options.compression_level > 9) {
+        throw std::invalid_argument("Compression level must be between 0 and 9 for " + name);
+    }
+    if (options.compression_level > 0 && H5Zfilter_avail(H5Z_FILTER_DEFLATE) <= 0) {
+        throw std::runtime_error("HDF5 library was built without deflate support, cannot compress " + name);
+    }
+
+    // Reduced precision applies to double matrices, which are converted on the way in and out
+    const StorageType storage = options.storage;
+    if (storage != StorageType::Float64 && H5Tequal(type, H5T_NATIVE_DOUBLE) <= 0) {
+        throw std::invalid_argument("Reduced precision storage needs a double matrix: " + name);
+    }
+    if (isScaled(storage) && !(std::isfinite(options.scale) && options.scale > 0 && std::isfinite(options.offset))) {
+        throw std::invalid_argument("Quantisation scale must be positive and finite for " + name);
+    }
+    Quantisation quantisation{options.scale, options.offset, storage == StorageType::ScaledInt16 ? std::numeric_limits<int16_t>::min() : std::numeric_limits<int32_t>::min()};
+    hid_t stored_type = type;
+    if (storage == StorageType::Float32) stored_type = H5T_NATIVE_FLOAT;
+    if (storage == StorageType::ScaledInt16) stored_type = H5T_NATIVE_INT16;
+    if (storage == StorageType::ScaledInt32) stored_type = H5T_NATIVE_INT32;
+
+    std::vector<hsize_t> max_dims = dims;
+    for (int axis : options.unlimited_axes) {
+        if (axis < 0 || axis >= rank || max_dims[axis] == H5S_UNLIMITED) {
+            throw std::invalid_argument("Unlimited axes are out of range or repeated for " + name);
+        }
+        max_dims[axis] = H5S_UNLIMITED;
+    }
+
+    std::vector<hsize_t> chunk;
+    ChunkLayout layout; // Chunk cache stays at the library default unless tuned
+    if (chunked) {
+        // Axes that start empty are planned as one slice thick
+        std::vector<hsize_t> planned = dims;
+        for (hsize_t& extent : planned) extent = std::max<hsize_t>(extent, 1);
+        if (!options.chunk_dims.empty()) {
+            chunk = options.chunk_dims;
+        } else if (!options.access.empty()) {
+            layout = ChunkTuner::tune(planned, options.access, default_chunk_elements);
+            chunk = layout.chunk;
+        } else {
+            chunk = blockShape(dims, default_chunk_elements);
+        }
+        if (chunk.size() != dims.size()) {
+            throw std::invalid_argument("Chunk shape rank does not match matrix rank for " + name);
+        }
+        for (int d = 0; d < rank; ++d) {
+            if (chunk[d] == 0 || (max_dims[d] != H5S_UNLIMITED && chunk[d] > std::max<hsize_t>(dims[d], 1))) {
+                throw std::invalid_argument("Chunk shape does not fit the matrix dimensions for " + name);
+            }
+        }
+    }
+
     // Define the data space for the dataset
-    hsize_t dims[4] = {N, M, O, P};
-    hid_t dataspace = H5Screate_simple(4, dims, nullptr);
+    hid_t dataspace = H5Screate_simple(rank, dims.data(), max_dims.data());
     if (dataspace < 0) {
         throw std::runtime_error("Failed to create dataspace for " + name);
     }
 
+    // Chunked matrices take NaN as the fill value, so unwritten chunks are never allocated.
+    // Scaled matrices fill with their NaN code, other integer matrices keep the default of 0.
+    const bool floating = H5Tget_class(stored_type) == H5T_FLOAT;
+    hid_t matrix_dcpl = dcpl;
+    if (chunked) {
+        const double fill = std::numeric_limits<double>::quiet_NaN();
+        matrix_dcpl = H5Pcopy(dcpl);
+        if (matrix_dcpl < 0
+            || H5Pset_chunk(matrix_dcpl, rank, chunk.data()) < 0
+            || (floating && H5Pset_fill_value(matrix_dcpl, H5T_NATIVE_DOUBLE, &fill) < 0)
+            || (isScaled(storage) && H5Pset_fill_value(matrix_dcpl, H5T_NATIVE_INT32, &quantisation.nan_code) < 0)
+            || H5Pset_alloc_time(matrix_dcpl, H5D_ALLOC_TIME_INCR) < 0
+            || H5Pset_fill_time(matrix_dcpl, H5D_FILL_TIME_IFSET) < 0
+            || (options.compression_level > 0 && H5Pset_shuffle(matrix_dcpl) < 0)
+            || (options.compression_level > 0 && H5Pset_deflate(matrix_dcpl, options.compression_level) < 0)) {
+            if (matrix_dcpl >= 0) H5Pclose(matrix_dcpl);
+            H5Sclose(dataspace);
+            throw std::runtime_error("Failed to set up chunked layout for " + name);
+        }
+    }
+
+    // Tuned matrices get a chunk cache that holds the working set of one access
+    hid_t matrix_dapl = dapl;
+    if (layout.cache_bytes > 0) {
+        matrix_dapl = H5Pcopy(dapl);
+        if (matrix_dapl < 0 || H5Pset_chunk_cache(matrix_dapl, layout.cache_slots, layout.cache_bytes, H5D_CHUNK_CACHE_W0_DEFAULT) < 0) {
+            if (matrix_dapl >= 0) H5Pclose(matrix_dapl);
+            if (matrix_dcpl != dcpl) H5Pclose(matrix_dcpl);
+            H5Sclose(dataspace);
+            throw std::runtime_error("Failed to set up chunk cache for " + name);
+        }
+    }
+
     // Create the dataset
-    hid_t dataset = H5Dcreate(file, name.c_str(), H5T_NATIVE_DOUBLE, dataspace, lcpl, dcpl, dapl);
+    hid_t dataset = H5_STATS_LIBRARY(H5Dcreate(file, name.c_str(), stored_type, dataspace, lcpl, matrix_dcpl, matrix_dapl));
+    if (matrix_dcpl != dcpl) H5Pclose(matrix_dcpl);
+    if (matrix_dapl != dapl) H5Pclose(matrix_dapl);
     if (dataset < 0) {
         H5Sclose(dataspace);
         throw std::runtime_error("Failed to create dataset: " + name);
     }
 
+    // Readers apply the same cache; the size is not part of the file format
+    if (layout.cache_bytes > 0) {
+        const uint64_t cache[2] = {layout.cache_slots, layout.cache_bytes};
+        hsize_t cache_dims[1] = {2};
+        hid_t cache_space = H5Screate_simple(1, cache_dims, nullptr);
+        hid_t attribute = H5Acreate(dataset, "chunk_cache", H5T_STD_U64LE, cache_space, H5P_DEFAULT, H5P_DEFAULT);
+        herr_t status = attribute < 0 ? -1 : H5Awrite(attribute, H5T_NATIVE_UINT64, cache);
+        if (attribute >= 0) H5Aclose(attribute);
+        H5Sclose(cache_space);
+        if (status < 0) {
+            H5Dclose(dataset);
+            H5Sclose(dataspace);
+            throw std::runtime_error("Failed to record chunk cache for " + name);
+        }
+    }
+
+    // Readers recognise scaled matrices by this attribute
+    if (isScaled(storage)) {
+        const double scale_offset[2] = {quantisation.scale, quantisation.offset};
+        hsize_t attribute_dims[1] = {2};
+        hid_t attribute_space = H5Screate_simple(1, attribute_dims, nullptr);
+        hid_t attribute = H5Acreate(dataset, "scale_offset", H5T_IEEE_F64LE, attribute_space, H5P_DEFAULT, H5P_DEFAULT);
+        herr_t status = attribute < 0 ? -1 : H5Awrite(attribute, H5T_NATIVE_DOUBLE, scale_offset);
+        if (attribute >= 0) H5Aclose(attribute);
+        H5Sclose(attribute_space);
+        if (status < 0) {
+            H5Dclose(dataset);
+            H5Sclose(dataspace);
+            throw std::runtime_error("Failed to record quantisation for " + name);
+        }
+    }
+
     // Fill the dataset with NaN values
-    std::vector<double> nanBuffer(N * M * O * P, std::numeric_limits<double>::quiet_NaN());
-    herr_t status = H5Dwrite(dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, dxpl, nanBuffer.data());
-    if (status < 0) {
-        H5Dclose(dataset);
-        H5Sclose(dataspace);
-        throw std::runtime_error("Failed to initialize dataset with NaN values for " + name);
+    if (!chunked && (floating || isScaled(storage))) {
+        size_t elements = 1;
+        for (hsize_t extent : dims) elements *= extent;
+        herr_t status;
+        if (isScaled(storage)) {
+            std::vector<int32_t> nanBuffer(elements, quantisation.nan_code);
+            status = H5_STATS_LIBRARY(H5Dwrite(dataset, H5T_NATIVE_INT32, H5S_ALL, H5S_ALL, dxpl, nanBuffer.data()));
+        } else {
+            std::vector<double> nanBuffer(elements, std::numeric_limits<double>::quiet_NaN());
+            status = H5_STATS_LIBRARY(H5Dwrite(dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, dxpl, nanBuffer.data()));
+        }
+        if (status < 0) {
+            H5Dclose(dataset);
+            H5Sclose(dataspace);
+            throw std::runtime_error("Failed to initialize dataset with NaN values for " + name);
+        }
     }
 
     H5Sclose(dataspace);
     open_datasets.push_back(dataset);
+    if (H5Tequal(type, H5T_NATIVE_DOUBLE) > 0) {
+        // Staging and direct chunk writes work on doubles
+        registerMatrix(dataset, dims, chunk, options.compression_level);
+        MatrixInfo& info = matrices[dataset];
+        for (int axis : options.unlimited_axes) info.unlimited[axis] = true;
+        info.storage = storage;
+        info.quantisation = quantisation;
+    }
     return dataset;
 }
 
-hid_t H5FileWriter::generate5DMatrix(const std::string& name, size_t N, size_t M, size_t O, size_t P, size_t Q) {
-    // Define the data space for the dataset
-    hsize_t dims[5] = {N, M, O, P, Q};
-    hid_t dataspace = H5Screate_simple(5, dims, nullptr);
+hid_t H5FileWriter::generateVirtualMatrix(const std::string& name, const std::vector<hsize_t>& dims, const std::vector<VirtualSource>& sources) {
+    H5_STATS_OPERATION(H5Operation::Create, 0);
+    requireNotLive(name);
+    const int rank = static_cast<int>(dims.size());
+    if (rank == 0) {
+        throw std::invalid_argument("Virtual matrix needs at least one dimension: " + name);
+    }
+
+    hid_t dataspace = H5Screate_simple(rank, dims.data(), nullptr);
     if (dataspace < 0) {
         throw std::runtime_error("Failed to create dataspace for " + name);
     }
 
-    // Create the dataset
-    hid_t dataset = H5Dcreate(file, name.c_str(), H5T_NATIVE_DOUBLE, dataspace, lcpl, dcpl, dapl);
-    if (dataset < 0) {
+    const double fill = std::numeric_limits<double>::quiet_NaN();
+    hid_t virtual_dcpl = H5Pcopy(dcpl);
+    if (virtual_dcpl < 0 || H5Pset_fill_value(virtual_dcpl, H5T_NATIVE_DOUBLE, &fill) < 0) {
+        if (virtual_dcpl >= 0) H5Pclose(virtual_dcpl);
         H5Sclose(dataspace);
-        throw std::runtime_error("Failed to create dataset: " + name);
+        throw std::runtime_error("Failed to set up virtual layout for " + name);
     }
 
-    // Fill the dataset with NaN values
-    std::vector<double> nanBuffer(N * M * O * P * Q, std::numeric_limits<double>::quiet_NaN());
-    herr_t status = H5Dwrite(dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, dxpl, nanBuffer.data());
-    if (status < 0) {
-        H5Dclose(dataset);
-        H5Sclose(dataspace);
-        throw std::runtime_error("Failed to initialize dataset with NaN values for " + name);
+    // Each source maps whole onto a band of rows
+    std::vector<hsize_t> offset(rank, 0);
+    std::vector<hsize_t> count(dims);
+    for (const VirtualSource& source : sources) {
+        if (source.rows == 0) continue;
+        if (source.row_offset + source.rows > dims[0]) {
+            H5Pclose(virtual_dcpl);
+            H5Sclose(dataspace);
+            throw std::out_of_range("Virtual source " + source.file + ":" + source.dataset + " lies outside " + name);
+        }
+        offset[0] = source.row_offset;
+        count[0] = source.rows;
+        hid_t source_space = H5Screate_simple(rank, count.data(), nullptr);
+        herr_t status = source_space < 0 ? -1 : H5Sselect_hyperslab(dataspace, H5S_SELECT_SET, offset.data(), nullptr, count.data(), nullptr);
+        if (status >= 0) {
+            status = H5Pset_virtual(virtual_dcpl, dataspace, source.file.c_str(), source.dataset.c_str(), source_space);
+        }
+        if (source_space >= 0) H5Sclose(source_space);
+        if (status < 0) {
+            H5Pclose(virtual_dcpl);
+            H5Sclose(dataspace);
+            throw std::runtime_error("Failed to map " + source.file + ":" + source.dataset + " into " + name);
+        }
     }
+    H5Sselect_all(dataspace);
 
+    hid_t dataset = H5_STATS_LIBRARY(H5Dcreate(file, name.c_str(), H5T_NATIVE_DOUBLE, dataspace, lcpl, virtual_dcpl, dapl));
+    H5Pclose(virtual_dcpl);
     H5Sclose(dataspace);
+    if (dataset < 0) {
+        throw std::runtime_error("Failed to create dataset: " + name);
+    }
     open_datasets.push_back(dataset);
     return dataset;
 }
 
 void H5FileWriter::writeTo4DMatrix(hid_t dataset, double value, int i, int j, int k, int l) {
     hsize_t offset[4] = {static_cast<hsize_t>(i), static_cast<hsize_t>(j), static_cast<hsize_t>(k), static_cast<hsize_t>(l)};
-    hsize_t count[4] = {1, 1, 1, 1};
+    writePoint(dataset, value, offset, 4);
+}
 
-    // Create a memory space
-    hid_t memspace = H5Screate_simple(4, count, nullptr);
-    if (memspace < 0) {
-        throw std::runtime_error("Failed to create memory dataspace for writing value.");
+void H5FileWriter::writeTo5DMatrix(hid_t dataset, double value, int i, int j, int k, int l, int m) {
+    hsize_t offset[5] = {static_cast<hsize_t>(i), static_cast<hsize_t>(j), static_cast<hsize_t>(k), static_cast<hsize_t>(l), static_cast<hsize_t>(m)};
+    writePoint(dataset, value, offset, 5);
+}
+
+void H5FileWriter::writePointsTo4DMatrix(hid_t dataset, const std::vector<double>& values, const std::vector<hsize_t>& coords) {
+    writePoints(dataset, values, coords, 4);
+}
+
+void H5FileWriter::writePointsTo5DMatrix(hid_t dataset, const std::vector<double>& values, const std::vector<hsize_t>& coords) {
+    writePoints(dataset, values, coords, 5);
+}
+
+std::future<std::vector<double>> H5FileWriter::writeBlockAsync(hid_t dataset, const std::vector<hsize_t>& offset, const std::vector<hsize_t>& extents, std::vector<double> values) {
+    auto block = prepareBlock(dataset, offset, extents, values.size());
+    block->owned = std::move(values);
+    block->values = block->owned.data();
+    block->returns_buffer = true;
+    std::future<std::vector<double>> result = block->buffer_returned.get_future();
+    submitBlock(std::move(block));
+    return result;
+}
+
+std::future<void> H5FileWriter::writeBlockAsync(hid_t dataset, const std::vector<hsize_t>& offset, const std::vector<hsize_t>& extents, const double* values) {
+    size_t elements = 1;
+    for (hsize_t extent : extents) elements *= extent;
+    auto block = prepareBlock(dataset, offset, extents, elements);
+    block->values = values;
+    std::future<void> result = block->written.get_future();
+    submitBlock(std::move(block));
+    return result;
+}
+
+void H5FileWriter::setMaxInFlightBytes(size_t max_bytes) {
+    {
+        std::lock_guard<std::mutex> lock(block_mutex);
+        max_in_flight_bytes = std::max<size_t>(max_bytes, 1);
     }
+    block_finished.notify_all();
+}
 
-    // Select a hyperslab in the file dataspace
+void H5FileWriter::drain() {
+    std::unique_lock<std::mutex> lock(block_mutex);
+    block_finished.wait(lock, [this]() { return in_flight_bytes == 0 && block_queue.empty(); });
+}
+
+std::unique_ptr<H5FileWriter::BlockWrite> H5FileWriter::prepareBlock(hid_t dataset, const std::vector<hsize_t>& offset, const std::vector<hsize_t>& extents, size_t elements) {
+    // Shape errors surface here rather than through the future
     hid_t filespace = H5Dget_space(dataset);
     if (filespace < 0) {
-        H5Sclose(memspace);
         throw std::runtime_error("Failed to get filespace for dataset.");
     }
+    std::vector<hsize_t> dims(std::max(H5Sget_simple_extent_ndims(filespace), 0));
+    H5Sget_simple_extent_dims(filespace, dims.data(), nullptr);
+    H5Sclose(filespace);
+    auto registered = matrices.find(dataset);
+    if (registered != matrices.end()) {
+        dims = registered->second.dims; // Appended extent, not the spare capacity
+    }
+
+    if (offset.size() != dims.size() || extents.size() != dims.size()) {
+        throw std::invalid_argument("Block rank does not match matrix rank");
+    }
+    size_t expected = 1;
+    for (size_t d = 0; d < dims.size(); ++d) {
+        if (extents[d] == 0 || offset[d] + extents[d] > dims[d]) {
+            throw std::out_of_range("Matrix indices are out of bounds");
+        }
+        expected *= extents[d];
+    }
+    if (elements != expected) {
+        throw std::invalid_argument("Block holds " + std::to_string(elements) + " values, extents need " + std::to_string(expected));
+    }
+
+    auto block = std::make_unique<BlockWrite>();
+    block->dataset = dataset;
+    block->offset = offset;
+    block->extents = extents;
+    block->values = nullptr;
+    block->bytes = expected * sizeof(double);
+    block->storage = StorageType::Float64;
+    auto it = matrices.find(dataset);
+    if (it != matrices.end()) {
+        block->storage = it->second.storage;
+        block->quantisation = it->second.quantisation;
+    }
+    block->returns_buffer = false;
+    return block;
+}
+
+void H5FileWriter::submitBlock(std::unique_ptr<BlockWrite> block) {
+    liveTick();
+
+    // Without the library lock a second thread inside HDF5 is not safe
+    hbool_t threadsafe = false;
+    if (H5is_library_threadsafe(&threadsafe) < 0 || !threadsafe) {
+        writeBlock(*block);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(block_mutex);
+    block_finished.wait(lock, [&]() { return in_flight_bytes == 0 || in_flight_bytes + block->bytes <= max_in_flight_bytes; });
+    in_flight_bytes += block->bytes;
+    block_queue.push_back(std::move(block));
+    if (!block_thread.joinable()) {
+        block_thread = std::thread(&H5FileWriter::runBlockWrites, this);
+    }
+    lock.unlock();
+    block_submitted.notify_one();
+}
+
+void H5FileWriter::runBlockWrites() {
+    std::unique_lock<std::mutex> lock(block_mutex);
+    for (;;) {
+        block_submitted.wait(lock, [this]() { return block_stopping || !block_queue.empty(); });
+        if (block_queue.empty()) return;
+
+        // Keep the block queued until written so drain() waits for it
+        BlockWrite& block = *block_queue.front();
+        lock.unlock();
+        writeBlock(block);
+        lock.lock();
+
+        in_flight_bytes -= block.bytes;
+        block_queue.pop_front();
+        block_finished.notify_all();
+    }
+}
+
+void H5FileWriter::writeBlock(BlockWrite& block) {
+    H5_STATS_OPERATION(H5Operation::Write, block.bytes);
+    const int rank = static_cast<int>(block.extents.size());
+
+    hid_t filespace = H5Dget_space(block.dataset);
+    hid_t memspace = H5Screate_simple(rank, block.extents.data(), nullptr);
+    herr_t status = filespace < 0 || memspace < 0 ? -1
+        : H5Sselect_hyperslab(filespace, H5S_SELECT_SET, block.offset.data(), nullptr, block.extents.data(), nullptr);
+    if (status >= 0) {
+        hid_t memory_type;
+        const void* buffer = encodeValues(block.storage, block.quantisation, block.values, block.bytes / sizeof(double), memory_type);
+        status = H5_STATS_LIBRARY(H5Dwrite(block.dataset, memory_type, memspace, filespace, dxpl, buffer));
+    }
+    if (memspace >= 0) H5Sclose(memspace);
+    if (filespace >= 0) H5Sclose(filespace);
 
-    herr_t status = H5Sselect_hyperslab(filespace, H5S_SELECT_SET, offset, nullptr, count, nullptr);
     if (status < 0) {
-        H5Sclose(memspace);
-        H5Sclose(filespace);
-        throw std::runtime_error("Failed to select hyperslab for dataset.");
+        auto error = std::make_exception_ptr(std::runtime_error("Failed to write block to dataset."));
+        if (block.returns_buffer) {
+            block.buffer_returned.set_exception(error);
+        } else {
+            block.written.set_exception(error);
+        }
+    } else if (block.returns_buffer) {
+        block.buffer_returned.set_value(std::move(block.owned));
+    } else {
+        block.written.set_value();
     }
+}
 
-    // Write the value to the selected hyperslab
-    status = H5Dwrite(dataset, H5T_NATIVE_DOUBLE, memspace, filespace, dxpl, &value);
+void H5FileWriter::enableBufferedWrites(size_t tile_elements, size_t max_tiles_per_dataset) {
+    // Staged data was laid out for the old tile shape
+    flush();
+
+    this->buffered_writes = true;
+    this->tile_elements = std::max<size_t>(tile_elements, 1);
+    this->max_tiles_per_dataset = std::max<size_t>(max_tiles_per_dataset, 1);
+    for (auto& entry : matrices) {
+        entry.second.tile = stagingTileShape(entry.second);
+    }
+}
+
+void H5FileWriter::flush() {
+    H5_STATS_OPERATION(H5Operation::Write, 0);
+    drain();
+    for (auto& entry : matrices) {
+        flushMatrix(entry.first, entry.second);
+    }
+    writeCompressedChunks(true);
+    trimMatrices();
+}
+
+void H5FileWriter::appendSlab(hid_t dataset, int axis, const std::vector<double>& values) {
+    appendSlab(dataset, axis, values.data(), values.size());
+}
+
+void H5FileWriter::appendSlab(hid_t dataset, int axis, const double* values, size_t count) {
+    H5_STATS_OPERATION(H5Operation::Write, count * sizeof(double));
+    liveTick();
+
+    auto it = matrices.find(dataset);
+    if (it == matrices.end()) {
+        throw std::invalid_argument("Slabs can only be appended to double matrices created by this writer.");
+    }
+    MatrixInfo& info = it->second;
+    const int rank = static_cast<int>(info.dims.size());
+    if (axis < 0 || axis >= rank || !info.unlimited[axis]) {
+        throw std::out_of_range("Axis " + std::to_string(axis) + " is not an unlimited axis of the matrix.");
+    }
+    size_t slice = 1;
+    for (int d = 0; d < rank; ++d) {
+        if (d != axis) slice *= info.dims[d];
+    }
+    if (slice == 0 || count % slice != 0) {
+        throw std::invalid_argument("Appended values do not fill whole slices along axis " + std::to_string(axis) + ".");
+    }
+    const hsize_t rows = count / slice;
+    if (rows == 0) return;
+
+    // Anything staged or in flight was laid out for the current extent
+    drain();
+    flushMatrix(dataset, info);
+    writeCompressedChunks(true);
+
+    std::vector<hsize_t> offset(rank, 0);
+    std::vector<hsize_t> extents = info.dims;
+    offset[axis] = info.dims[axis];
+    extents[axis] = rows;
+    const hsize_t needed = info.dims[axis] + rows;
+    if (needed > info.capacity[axis]) {
+        // Doubling keeps the number of resizes logarithmic in the final extent
+        std::vector<hsize_t> capacity = info.capacity;
+        capacity[axis] = std::max({needed, 2 * capacity[axis], info.chunk[axis]});
+        if (H5_STATS_LIBRARY(H5Dset_extent(dataset, capacity.data())) < 0) {
+            throw std::runtime_error("Failed to extend dataset for appended slab.");
+        }
+        info.capacity = capacity;
+    }
+
+    hid_t filespace = H5Dget_space(dataset);
+    hid_t memspace = H5Screate_simple(rank, extents.data(), nullptr);
+    herr_t status = (filespace < 0 || memspace < 0) ? -1
+        : H5Sselect_hyperslab(filespace, H5S_SELECT_SET, offset.data(), nullptr, extents.data(), nullptr);
+    if (status >= 0) {
+        hid_t memory_type;
+        const void* buffer = encodeValues(info.storage, info.quantisation, values, count, memory_type);
+        status = H5_STATS_LIBRARY(H5Dwrite(dataset, memory_type, memspace, filespace, dxpl, buffer));
+    }
+    if (memspace >= 0) H5Sclose(memspace);
+    if (filespace >= 0) H5Sclose(filespace);
     if (status < 0) {
-        H5Sclose(memspace);
-        H5Sclose(filespace);
-        throw std::runtime_error("Failed to write value to dataset.");
+        throw std::runtime_error("Failed to write appended slab to dataset.");
     }
+    info.dims[axis] = needed;
+}
 
-    // Close resources
-    H5Sclose(memspace);
-    H5Sclose(filespace);
+void H5FileWriter::trimMatrices() {
+    // Readers only ever see the appended extent, never the spare capacity
+    for (auto& entry : matrices) {
+        MatrixInfo& info = entry.second;
+        if (info.capacity == info.dims) continue;
+        if (H5_STATS_LIBRARY(H5Dset_extent(entry.first, info.dims.data())) < 0) {
+            throw std::runtime_error("Failed to trim dataset to its appended extent.");
+        }
+        info.capacity = info.dims;
+    }
 }
 
-void H5FileWriter::writeTo5DMatrix(hid_t dataset, double value, int i, int j, int k, int l, int m) {
-    hsize_t offset[5] = {static_cast<hsize_t>(i), static_cast<hsize_t>(j), static_cast<hsize_t>(k), static_cast<hsize_t>(l), static_cast<hsize_t>(m)};
-    hsize_t count[5] = {1, 1, 1, 1, 1};
+std::vector<unsigned char> H5FileWriter::fileImage() {
+    if (storage == WriterStorage::Disk) {
+        throw std::runtime_error("File images are only available from in-memory writers: " + file_path);
+    }
+    flush();
+    if (H5_STATS_LIBRARY(H5Fflush(file, H5F_SCOPE_LOCAL)) < 0) {
+        throw std::runtime_error("Failed to flush file: " + file_path);
+    }
+    ssize_t size = H5Fget_file_image(file, nullptr, 0);
+    std::vector<unsigned char> image(size > 0 ? size : 0);
+    if (size <= 0 || H5_STATS_LIBRARY(H5Fget_file_image(file, image.data(), image.size())) != size) {
+        throw std::runtime_error("Failed to copy file image of " + file_path);
+    }
+    return image;
+}
+
+void H5FileWriter::startLiveProgress(std::chrono::milliseconds flush_interval) {
+    if (live_dataset >= 0) {
+        throw std::runtime_error("Live progress has already started for " + file_path);
+    }
+    flush();
+
+    hsize_t dims[1] = {2};
+    hid_t dataspace = H5Screate_simple(1, dims, nullptr);
+    if (dataspace < 0) throw std::runtime_error("Failed to create dataspace for " + std::string(live_progress_name));
+    hid_t dataset = H5_STATS_LIBRARY(H5Dcreate(file, live_progress_name, H5T_NATIVE_UINT64, dataspace, lcpl, dcpl, dapl));
+    H5Sclose(dataspace);
+    if (dataset < 0) throw std::runtime_error("Failed to create dataset: " + std::string(live_progress_name));
+    open_datasets.push_back(dataset);
+
+    if (H5_STATS_LIBRARY(H5Fstart_swmr_write(file)) < 0) {
+        throw std::runtime_error("Failed to start single-writer/multiple-reader mode for " + file_path);
+    }
+    live_dataset = dataset;
+    flushLiveProgress();
+
+    const auto interval = std::max(flush_interval, std::chrono::milliseconds(1));
+    live_thread = std::thread([this, interval]() {
+        std::unique_lock<std::mutex> lock(live_mutex);
+        while (!live_stop.wait_for(lock, interval, [this]() { return live_stopping; })) {
+            live_due.store(true, std::memory_order_relaxed);
+        }
+    });
+}
+
+void H5FileWriter::flushLiveProgress() {
+    if (live_dataset < 0) {
+        throw std::runtime_error("Live progress has not started for " + file_path);
+    }
+    live_due.store(false, std::memory_order_relaxed);
+    flush();
+
+    // Data first, then the generation readers poll for, then everything reaches the file
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    uint64_t progress[2] = {++live_generation, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now).count())};
+    if (H5_STATS_LIBRARY(H5Dwrite(live_dataset, H5T_NATIVE_UINT64, H5S_ALL, H5S_ALL, dxpl, progress)) < 0
+        || H5_STATS_LIBRARY(H5Fflush(file, H5F_SCOPE_LOCAL)) < 0) {
+        throw std::runtime_error("Failed to flush live progress to " + file_path);
+    }
+}
+
+void H5FileWriter::requireNotLive(const std::string& name) const {
+    // Live readers cannot reliably see objects created after the switch
+    if (live_dataset >= 0) {
+        throw std::runtime_error("Cannot create datasets after live progress has started: " + name);
+    }
+}
+
+void H5FileWriter::registerMatrix(hid_t dataset, const std::vector<hsize_t>& dims, const std::vector<hsize_t>& chunk, int compression_level) {
+    MatrixInfo& info = matrices[dataset];
+    info.dims = dims;
+    info.chunk = chunk;
+    info.compression_level = compression_level;
+    info.unlimited.assign(dims.size(), false);
+    info.capacity = dims;
+    if (buffered_writes) {
+        info.tile = stagingTileShape(info);
+    }
+}
+
+std::vector<hsize_t> H5FileWriter::stagingTileShape(const MatrixInfo& info) const {
+    // Tiles line up with chunks so each flush rewrites whole chunks
+    if (!info.chunk.empty()) {
+        return info.chunk;
+    }
+    return blockShape(info.dims, tile_elements);
+}
+
+const void* H5FileWriter::encode(hid_t dataset, const double* values, size_t count, hid_t& memory_type) const {
+    auto it = matrices.find(dataset);
+    if (it == matrices.end()) {
+        memory_type = H5T_NATIVE_DOUBLE;
+        return values;
+    }
+    return encodeValues(it->second.storage, it->second.quantisation, values, count, memory_type);
+}
+
+void H5FileWriter::writePoint(hid_t dataset, double value, const hsize_t* offset, int rank) {
+    H5_STATS_OPERATION(H5Operation::Write, sizeof(double));
+    liveTick();
+
+    auto it = matrices.find(dataset);
+    if (it != matrices.end() && it->second.dims.size() == static_cast<size_t>(rank)) {
+        if (buffered_writes) {
+            stagePoint(it->second, dataset, value, offset);
+            return;
+        }
+        // The file extent may run ahead of the appended rows, which the next flush trims
+        for (int d = 0; d < rank; ++d) {
+            if (offset[d] >= it->second.dims[d]) {
+                throw std::out_of_range("Matrix indices are out of bounds");
+            }
+        }
+    }
+
+    // Chunks still being compressed must land before anything overwrites them
+    writeCompressedChunks(true);
+
+    std::vector<hsize_t> count(rank, 1);
 
     // Create a memory space
-    hid_t memspace = H5Screate_simple(5, count, nullptr);
+    hid_t memspace = H5Screate_simple(rank, count.data(), nullptr);
     if (memspace < 0) {
         throw std::runtime_error("Failed to create memory dataspace for writing value.");
     }
@@ -196,7 +1038,7 @@ void H5FileWriter::writeTo5DMatrix(hid_t dataset, double value, int i, int j, in
         throw std::runtime_error("Failed to get filespace for dataset.");
     }
 
-    herr_t status = H5Sselect_hyperslab(filespace, H5S_SELECT_SET, offset, nullptr, count, nullptr);
+    herr_t status = H5Sselect_hyperslab(filespace, H5S_SELECT_SET, offset, nullptr, count.data(), nullptr);
     if (status < 0) {
         H5Sclose(memspace);
         H5Sclose(filespace);
@@ -204,7 +1046,9 @@ void H5FileWriter::writeTo5DMatrix(hid_t dataset, double value, int i, int j, in
     }
 
     // Write the value to the selected hyperslab
-    status = H5Dwrite(dataset, H5T_NATIVE_DOUBLE, memspace, filespace, dxpl, &value);
+    hid_t memory_type = H5T_NATIVE_DOUBLE;
+    const void* buffer = encode(dataset, &value, 1, memory_type);
+    status = H5_STATS_LIBRARY(H5Dwrite(dataset, memory_type, memspace, filespace, dxpl, buffer));
     if (status < 0) {
         H5Sclose(memspace);
         H5Sclose(filespace);
@@ -216,186 +1060,920 @@ void H5FileWriter::writeTo5DMatrix(hid_t dataset, double value, int i, int j, in
     H5Sclose(filespace);
 }
 
+void H5FileWriter::writePoints(hid_t dataset, const std::vector<double>& values, const std::vector<hsize_t>& coords, int rank) {
+    H5_STATS_OPERATION(H5Operation::Write, values.size() * sizeof(double));
+    liveTick();
 
-H5FileReader::H5FileReader(const std::string& file_path) {
+    if (coords.size() != values.size() * rank) {
+        throw std::invalid_argument("Expected " + std::to_string(rank) + " coordinates per value.");
+    }
+    if (values.empty()) return;
+
+    // Staged values for this matrix must land before the batch so the batch wins
+    auto it = matrices.find(dataset);
+    if (it != matrices.end()) {
+        flushMatrix(dataset, it->second);
+    }
+    writeCompressedChunks(true);
+
+    hid_t filespace = H5Dget_space(dataset);
+    if (filespace < 0) {
+        throw std::runtime_error("Failed to get filespace for dataset.");
+    }
+
+    std::vector<hsize_t> dims(rank);
+    if (H5Sget_simple_extent_ndims(filespace) != rank) {
+        H5Sclose(filespace);
+        throw std::invalid_argument("Dataset rank does not match coordinates.");
+    }
+    H5Sget_simple_extent_dims(filespace, dims.data(), nullptr);
+    if (it != matrices.end()) {
+        dims = it->second.dims; // Appended extent, not the spare capacity
+    }
+    try {
+        checkCoordinates(coords.data(), values.size(), dims);
+    } catch (...) {
+        H5Sclose(filespace);
+        throw;
+    }
+
+    hsize_t elements = values.size();
+    hid_t memspace = H5Screate_simple(1, &elements, nullptr);
+    herr_t status = memspace < 0 ? -1 : H5Sselect_elements(filespace, H5S_SELECT_SET, values.size(), coords.data());
+    if (status < 0) {
+        if (memspace >= 0) H5Sclose(memspace);
+        H5Sclose(filespace);
+        throw std::runtime_error("Failed to select points for dataset.");
+    }
+
+    hid_t memory_type = H5T_NATIVE_DOUBLE;
+    const void* buffer = encode(dataset, values.data(), values.size(), memory_type);
+    status = H5_STATS_LIBRARY(H5Dwrite(dataset, memory_type, memspace, filespace, dxpl, buffer));
+    H5Sclose(memspace);
+    H5Sclose(filespace);
+    if (status < 0) {
+        throw std::runtime_error("Failed to write points to dataset.");
+    }
+}
+
+bool H5FileWriter::stagedPoint(hid_t dataset, const hsize_t* offset, double& value) const {
+    auto it = matrices.find(dataset);
+    if (it == matrices.end() || it->second.tiles.empty()) {
+        return false;
+    }
+    const MatrixInfo& info = it->second;
+    const size_t rank = info.dims.size();
+
+    hsize_t tile_index = 0;
+    for (size_t d = 0; d < rank; ++d) {
+        hsize_t tiles_along = (info.dims[d] + info.tile[d] - 1) / info.tile[d];
+        tile_index = tile_index * tiles_along + offset[d] / info.tile[d];
+    }
+    auto tile = info.tiles.find(tile_index);
+    if (tile == info.tiles.end()) {
+        return false;
+    }
+
+    size_t position = 0;
+    for (size_t d = 0; d < rank; ++d) {
+        position = position * tile->second.count[d] + (offset[d] - tile->second.offset[d]);
+    }
+    if (!tile->second.written[position]) {
+        return false;
+    }
+    value = tile->second.values[position];
+    return true;
+}
+
+void H5FileWriter::stagePoint(MatrixInfo& info, hid_t dataset, double value, const hsize_t* offset) {
+    const size_t rank = info.dims.size();
+
+    // Locate the tile holding this point
+    hsize_t tile_index = 0;
+    for (size_t d = 0; d < rank; ++d) {
+        if (offset[d] >= info.dims[d]) {
+            throw std::out_of_range("Matrix indices are out of bounds");
+        }
+        hsize_t tiles_along = (info.dims[d] + info.tile[d] - 1) / info.tile[d];
+        tile_index = tile_index * tiles_along + offset[d] / info.tile[d];
+    }
+
+    auto it = info.tiles.find(tile_index);
+    if (it == info.tiles.end()) {
+        // Make room by writing out the least recently used tile
+        if (info.tiles.size() >= max_tiles_per_dataset) {
+            auto oldest = info.tiles.begin();
+            for (auto candidate = info.tiles.begin(); candidate != info.tiles.end(); ++candidate) {
+                if (candidate->second.last_used < oldest->second.last_used) {
+                    oldest = candidate;
+                }
+            }
+            flushTile(dataset, info, oldest->second);
+            info.tiles.erase(oldest);
+        }
+
+        StagingTile tile;
+        tile.offset.resize(rank);
+        tile.count.resize(rank);
+        size_t elements = 1;
+        for (size_t d = 0; d < rank; ++d) {
+            tile.offset[d] = offset[d] - offset[d] % info.tile[d];
+            tile.count[d] = std::min(info.tile[d], info.dims[d] - tile.offset[d]);
+            elements *= tile.count[d];
+        }
+        tile.values.resize(elements);
+        tile.written.resize(elements, false);
+        it = info.tiles.emplace(tile_index, std::move(tile)).first;
+    }
+
+    StagingTile& tile = it->second;
+    size_t position = 0;
+    for (size_t d = 0; d < rank; ++d) {
+        position = position * tile.count[d] + (offset[d] - tile.offset[d]);
+    }
+    tile.values[position] = value;
+    if (!tile.written[position]) {
+        tile.written[position] = true;
+        tile.written_count++;
+    }
+    tile.last_used = ++tile_clock;
+
+    // A completed tile goes straight to the file
+    if (tile.written_count == tile.values.size()) {
+        flushTile(dataset, info, tile);
+        info.tiles.erase(it);
+    }
+}
+
+void H5FileWriter::flushTile(hid_t dataset, const MatrixInfo& info, const StagingTile& tile) {
+    const int rank = static_cast<int>(tile.offset.size());
+
+#ifdef HDF5MT_HAVE_ZLIB
+    // Complete chunks of compressed matrices bypass the library filter pipeline.
+    // Not for single-chunk matrices: HDF5 1.10 reads stale data from those
+    // through the open dataset after a direct chunk write. Chunks are encoded
+    // as doubles, so reduced precision matrices go through the library too.
+    if (info.compression_level > 0 && tile.written_count == tile.values.size() && info.chunk != info.dims
+        && info.storage == StorageType::Float64) {
+        compressChunk(dataset, info, tile);
+        return;
+    }
+#else
+    (void)info;
+#endif
+    writeCompressedChunks(true);
+
+    hid_t filespace = H5Dget_space(dataset);
+    if (filespace < 0) {
+        throw std::runtime_error("Failed to get filespace for dataset.");
+    }
+
+    hid_t memspace;
+    herr_t status;
+    std::vector<double> values;
+    const double* buffer = tile.values.data();
+    if (tile.written_count == tile.values.size()) {
+        // Whole tile: one contiguous hyperslab
+        memspace = H5Screate_simple(rank, tile.count.data(), nullptr);
+        status = H5Sselect_hyperslab(filespace, H5S_SELECT_SET, tile.offset.data(), nullptr, tile.count.data(), nullptr);
+    } else {
+        // Partial tile: only the elements that were actually written
+        std::vector<hsize_t> coords;
+        coords.reserve(tile.written_count * rank);
+        values.reserve(tile.written_count);
+        std::vector<hsize_t> position(rank, 0);
+        for (size_t n = 0; n < tile.values.size(); ++n) {
+            if (tile.written[n]) {
+                for (int d = 0; d < rank; ++d) {
+                    coords.push_back(tile.offset[d] + position[d]);
+                }
+                values.push_back(tile.values[n]);
+            }
+            for (int d = rank - 1; d >= 0; --d) {
+                if (++position[d] < tile.count[d]) break;
+                position[d] = 0;
+            }
+        }
+        hsize_t elements = values.size();
+        memspace = H5Screate_simple(1, &elements, nullptr);
+        status = H5Sselect_elements(filespace, H5S_SELECT_SET, values.size(), coords.data());
+        buffer = values.data();
+    }
+
+    if (memspace < 0 || status < 0) {
+        if (memspace >= 0) H5Sclose(memspace);
+        H5Sclose(filespace);
+        throw std::runtime_error("Failed to select staged tile for dataset.");
+    }
+
+    hid_t memory_type;
+    const void* encoded = encodeValues(info.storage, info.quantisation, buffer, tile.written_count, memory_type);
+    status = H5_STATS_LIBRARY(H5Dwrite(dataset, memory_type, memspace, filespace, dxpl, encoded));
+    H5Sclose(memspace);
+    H5Sclose(filespace);
+    if (status < 0) {
+        throw std::runtime_error("Failed to write staged tile to dataset.");
+    }
+}
+
+void H5FileWriter::compressChunk(hid_t dataset, const MatrixInfo& info, const StagingTile& tile) {
+#ifdef HDF5MT_HAVE_ZLIB
+    const size_t rank = info.chunk.size();
+
+    // Edge chunks are stored full size, padded with the fill value
+    size_t chunk_elements = 1;
+    for (hsize_t extent : info.chunk) chunk_elements *= extent;
+    std::vector<double> values;
+    if (chunk_elements == tile.values.size()) {
+        values = tile.values;
+    } else {
+        values.assign(chunk_elements, std::numeric_limits<double>::quiet_NaN());
+        size_t row = tile.count[rank - 1];
+        size_t rows = tile.values.size() / row;
+        for (size_t n = 0; n < rows; ++n) {
+            size_t remainder = n;
+            size_t target = 0;
+            size_t scale = info.chunk[rank - 1];
+            for (size_t d = rank - 1; d-- > 0;) {
+                target += (remainder % tile.count[d]) * scale;
+                remainder /= tile.count[d];
+                scale *= info.chunk[d];
+            }
+            std::copy(tile.values.begin() + n * row, tile.values.begin() + (n + 1) * row, values.begin() + target);
+        }
+    }
+
+    int level = info.compression_level;
+    PendingChunk pending;
+    pending.dataset = dataset;
+    pending.offset = tile.offset;
+    pending.bytes = ThreadPool::shared().submit([values = std::move(values), level]() { return shuffleAndDeflate(values, level); });
+    pending_chunks.push_back(std::move(pending));
+
+    writeCompressedChunks(false);
+#else
+    (void)dataset;
+    (void)info;
+    (void)tile;
+#endif
+}
+
+void H5FileWriter::writeCompressedChunks(bool wait_for_all) {
+    // Write finished chunks in submission order, waiting only to keep a bounded number in flight
+    const size_t max_in_flight = 2 * ThreadPool::shared().size();
+    while (!pending_chunks.empty()) {
+        PendingChunk& front = pending_chunks.front();
+        if (!wait_for_all && pending_chunks.size() <= max_in_flight
+            && front.bytes.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            break;
+        }
+
+        std::vector<unsigned char> bytes = front.bytes.get();
+        herr_t status = H5_STATS_LIBRARY(H5Dwrite_chunk(front.dataset, dxpl, 0, front.offset.data(), bytes.size(), bytes.data()));
+        pending_chunks.pop_front();
+        if (status < 0) {
+            throw std::runtime_error("Failed to write compressed chunk to dataset.");
+        }
+    }
+}
+
+void H5FileWriter::flushMatrix(hid_t dataset, MatrixInfo& info) {
+    while (!info.tiles.empty()) {
+        flushTile(dataset, info, info.tiles.begin()->second);
+        info.tiles.erase(info.tiles.begin());
+    }
+}
+
+
+H5FileReader::H5FileReader(const std::string& file_path, ReaderMode mode) {
     this->file_path = file_path;
-    file = H5Fopen(file_path.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+    live = mode == ReaderMode::Live;
+    file = H5Fopen(file_path.c_str(), live ? H5F_ACC_RDONLY | H5F_ACC_SWMR_READ : H5F_ACC_RDONLY, H5P_DEFAULT);
     if (file < 0) {
+        if (live) {
+            throw std::runtime_error("Failed to open HDF5 file for live reading, has its writer started live progress? " + file_path);
+        }
         throw std::runtime_error("Failed to open HDF5 file: " + file_path);
     }
+
+    std::error_code ec;
+    std::filesystem::path canonical = std::filesystem::canonical(file_path, ec);
+    auto modified = std::filesystem::last_write_time(file_path, ec);
+    file_identity = (canonical.empty() ? file_path : canonical.string()) + "@" + std::to_string(modified.time_since_epoch().count());
+
+    if (live) {
+        live_generation.store(readLiveProgress().generation);
+    }
+}
+
+H5FileReader::H5FileReader(std::vector<unsigned char> image, const std::string& name) {
+    // The core driver compares files by name, so every image opens under its own
+    static std::atomic<uint64_t> images{0};
+    const uint64_t number = images.fetch_add(1);
+    file_path = name;
+    file_identity = "image#" + std::to_string(number);
+    this->image = std::make_shared<const std::vector<unsigned char>>(std::move(image));
+
+    hid_t access_plist = H5Pcreate(H5P_FILE_ACCESS);
+    if (access_plist < 0
+        || H5Pset_fapl_core(access_plist, memory_increment, false) < 0
+        || H5Pset_file_image(access_plist, const_cast<unsigned char*>(this->image->data()), this->image->size()) < 0) {
+        if (access_plist >= 0) H5Pclose(access_plist);
+        throw std::runtime_error("Failed to set up file image: " + name);
+    }
+    file = H5Fopen(file_identity.c_str(), H5F_ACC_RDONLY, access_plist);
+    H5Pclose(access_plist);
+    if (file < 0) {
+        throw std::runtime_error("Failed to open HDF5 file image: " + name);
+    }
 }
 
 H5FileReader::~H5FileReader() {
+    // Cached datasets have to be closed before the file
+    dataset_cache.clear();
+    dataset_recency.clear();
     H5Fclose(file);
 }
 
-std::vector<double> H5FileReader::readMatrixAxisFromDataset(const std::string& name) {
-    hid_t dataset = H5Dopen(file, name.c_str(), H5P_DEFAULT);
-    if (dataset < 0) throw std::runtime_error("Failed to open dataset: " + name);
+H5FileReader::DatasetEntry::~DatasetEntry() {
+    if (dataspace >= 0) H5Sclose(dataspace);
+    if (dataset >= 0) H5Dclose(dataset);
+}
 
-    hid_t dataspace = H5Dget_space(dataset);
-    if (dataspace < 0) throw std::runtime_error("Failed to get dataspace for " + name);
+void H5FileReader::setDatasetCacheLimit(size_t max_datasets) {
+    std::lock_guard<std::mutex> lock(dataset_mutex);
+    dataset_cache_limit = max_datasets;
+    while (dataset_cache_limit > 0 && dataset_cache.size() > dataset_cache_limit) {
+        dataset_cache.erase(dataset_recency.back());
+        dataset_recency.pop_back();
+    }
+}
 
-    hsize_t dims[1];
-    H5Sget_simple_extent_dims(dataspace, dims, nullptr);
+hid_t H5FileReader::chunkCacheAccessList(const std::string& name) {
+    // Matrices tuned for an access pattern carry their chunk cache size
+    if (H5Aexists_by_name(file, name.c_str(), "chunk_cache", H5P_DEFAULT) <= 0) {
+        return H5P_DEFAULT;
+    }
+    uint64_t cache[2] = {0, 0};
+    hid_t attribute = H5Aopen_by_name(file, name.c_str(), "chunk_cache", H5P_DEFAULT, H5P_DEFAULT);
+    herr_t status = attribute < 0 ? -1 : H5Aread(attribute, H5T_NATIVE_UINT64, cache);
+    if (attribute >= 0) H5Aclose(attribute);
+    if (status < 0 || cache[1] == 0) {
+        return H5P_DEFAULT;
+    }
 
-    std::vector<double> axis(dims[0]);
-    H5Dread(dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, axis.data());
+    hid_t access_plist = H5Pcreate(H5P_DATASET_ACCESS);
+    if (access_plist < 0 || H5Pset_chunk_cache(access_plist, cache[0], cache[1], H5D_CHUNK_CACHE_W0_DEFAULT) < 0) {
+        if (access_plist >= 0) H5Pclose(access_plist);
+        return H5P_DEFAULT;
+    }
+    return access_plist;
+}
 
-    H5Sclose(dataspace);
-    H5Dclose(dataset);
+std::shared_ptr<H5FileReader::DatasetEntry> H5FileReader::openDataset(const std::string& name) {
+    {
+        std::lock_guard<std::mutex> lock(dataset_mutex);
+        auto it = dataset_cache.find(name);
+        if (it != dataset_cache.end()) {
+            dataset_recency.splice(dataset_recency.begin(), dataset_recency, it->second.recency);
+            return it->second.entry;
+        }
+    }
+
+    // Open outside the lock; entries stay alive while a reader thread holds them
+    auto entry = std::make_shared<DatasetEntry>();
+    hid_t access_plist = chunkCacheAccessList(name);
+    entry->dataset = H5_STATS_LIBRARY(H5Dopen(file, name.c_str(), access_plist));
+    if (access_plist != H5P_DEFAULT) H5Pclose(access_plist);
+    if (entry->dataset < 0) {
+        throw std::runtime_error("Failed to open dataset: " + name);
+    }
+
+    entry->dataspace = H5Dget_space(entry->dataset);
+    if (entry->dataspace < 0) {
+        throw std::runtime_error("Failed to get dataspace for dataset: " + name);
+    }
+
+    int rank = H5Sget_simple_extent_ndims(entry->dataspace);
+    if (rank < 0) {
+        throw std::runtime_error("Failed to get dimensions of dataset: " + name);
+    }
+    entry->dims.resize(rank);
+    H5Sget_simple_extent_dims(entry->dataspace, entry->dims.data(), nullptr);
+
+    hid_t create_plist = H5Dget_create_plist(entry->dataset);
+    if (create_plist >= 0) {
+        if (H5Pget_layout(create_plist) == H5D_CHUNKED && rank > 0) {
+            entry->chunk.resize(rank);
+            H5Pget_chunk(create_plist, rank, entry->chunk.data());
+        }
+        H5Pclose(create_plist);
+    }
+    entry->cache_block = entry->chunk.empty() ? blockShape(entry->dims, cache_block_elements) : entry->chunk;
+
+    // Reduced precision matrices are widened to double by readValues
+    hid_t type = H5Dget_type(entry->dataset);
+    if (type >= 0) {
+        const H5T_class_t type_class = H5Tget_class(type);
+        const size_t type_size = H5Tget_size(type);
+        if (type_class == H5T_FLOAT && type_size == sizeof(float)) {
+            entry->storage = StorageType::Float32;
+        } else if (type_class == H5T_INTEGER && (type_size == 2 || type_size == 4) && H5Aexists(entry->dataset, "scale_offset") > 0) {
+            double scale_offset[2];
+            hid_t attribute = H5Aopen(entry->dataset, "scale_offset", H5P_DEFAULT);
+            herr_t status = attribute < 0 ? -1 : H5Aread(attribute, H5T_NATIVE_DOUBLE, scale_offset);
+            if (attribute >= 0) H5Aclose(attribute);
+            if (status < 0) {
+                H5Tclose(type);
+                throw std::runtime_error("Failed to read quantisation of dataset: " + name);
+            }
+            entry->storage = type_size == 2 ? StorageType::ScaledInt16 : StorageType::ScaledInt32;
+            entry->quantisation.scale = scale_offset[0];
+            entry->quantisation.offset = scale_offset[1];
+            entry->quantisation.nan_code = type_size == 2 ? std::numeric_limits<int16_t>::min() : std::numeric_limits<int32_t>::min();
+        }
+        H5Tclose(type);
+    }
+
+    if (memory_mapping) {
+        mapDataset(*entry);
+    }
+
+    std::lock_guard<std::mutex> lock(dataset_mutex);
+    auto it = dataset_cache.find(name);
+    if (it != dataset_cache.end()) {
+        // Another thread got there first
+        dataset_recency.splice(dataset_recency.begin(), dataset_recency, it->second.recency);
+        return it->second.entry;
+    }
+    dataset_recency.push_front(name);
+    dataset_cache[name] = CacheSlot{entry, dataset_recency.begin()};
+    if (live) live_entries.push_back(entry);
+    if (dataset_cache_limit > 0 && dataset_cache.size() > dataset_cache_limit) {
+        dataset_cache.erase(dataset_recency.back());
+        dataset_recency.pop_back();
+    }
+    return entry;
+}
+
+void H5FileReader::setMemoryMapping(bool enabled) {
+    std::lock_guard<std::mutex> lock(dataset_mutex);
+    memory_mapping = enabled;
+
+    // Reopen cached datasets under the new setting
+    dataset_cache.clear();
+    dataset_recency.clear();
+}
+
+void H5FileReader::setBlockCache(H5BlockCache* cache) {
+    // Blocks of a file still being written would go stale
+    block_cache.store(live ? nullptr : cache);
+}
+
+void H5FileReader::setReadahead(size_t blocks) {
+    readahead_blocks.store(blocks);
+}
+
+LiveProgress H5FileReader::readLiveProgress() {
+    LiveProgress progress;
+    if (H5Lexists(file, live_progress_name, H5P_DEFAULT) <= 0) {
+        return progress;
+    }
+
+    uint64_t values[2] = {0, 0};
+    hid_t dataset = H5Dopen(file, live_progress_name, H5P_DEFAULT);
+    herr_t status = dataset < 0 ? -1 : H5Drefresh(dataset);
+    if (status >= 0) {
+        status = H5_STATS_LIBRARY(H5Dread(dataset, H5T_NATIVE_UINT64, H5S_ALL, H5S_ALL, H5P_DEFAULT, values));
+    }
+    if (dataset >= 0) H5Dclose(dataset);
+    if (status < 0) {
+        throw std::runtime_error("Failed to read live progress from " + file_path);
+    }
+    progress.generation = values[0];
+    progress.flushed = std::chrono::system_clock::time_point(std::chrono::milliseconds(values[1]));
+    return progress;
+}
+
+LiveProgress H5FileReader::refresh() {
+    if (!live) {
+        throw std::runtime_error("Reader was not opened in live mode: " + file_path);
+    }
+    LiveProgress progress = readLiveProgress();
+
+    {
+        // Handles from openMatrix may hold entries that have left the cache
+        std::lock_guard<std::mutex> lock(dataset_mutex);
+        std::vector<std::weak_ptr<DatasetEntry>> alive;
+        for (auto& weak : live_entries) {
+            if (auto entry = weak.lock()) {
+                if (H5Drefresh(entry->dataset) < 0) {
+                    throw std::runtime_error("Failed to refresh a dataset in " + file_path);
+                }
+                alive.push_back(weak);
+            }
+        }
+        live_entries.swap(alive);
+
+        // Reopened on next use, so shapes are read again
+        dataset_cache.clear();
+        dataset_recency.clear();
+    }
+    {
+        std::lock_guard<std::mutex> lock(dictionary_mutex);
+        dictionary_cache.clear();
+    }
+
+    live_generation.store(progress.generation);
+    return progress;
+}
+
+bool H5FileReader::poll(std::chrono::milliseconds timeout) {
+    if (!live) {
+        throw std::runtime_error("Reader was not opened in live mode: " + file_path);
+    }
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    for (;;) {
+        if (readLiveProgress().generation != live_generation.load()) {
+            refresh();
+            return true;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(deadline - now, std::chrono::milliseconds(10)));
+    }
+}
+
+void H5FileReader::mapDataset(DatasetEntry& entry) {
+    // Only contiguous, unfiltered, native double data in a plain file can be read in place
+    if (!entry.chunk.empty()) return;
+
+    hid_t create_plist = H5Dget_create_plist(entry.dataset);
+    if (create_plist < 0) return;
+    bool contiguous = H5Pget_layout(create_plist) == H5D_CONTIGUOUS && H5Pget_external_count(create_plist) == 0;
+    H5Pclose(create_plist);
+    if (!contiguous) return;
+
+    hid_t type = H5Dget_type(entry.dataset);
+    if (type < 0) return;
+    bool native_double = H5Tequal(type, H5T_NATIVE_DOUBLE) > 0;
+    H5Tclose(type);
+    if (!native_double) return;
+
+    if (!image) {
+        hid_t access_plist = H5Fget_access_plist(file);
+        if (access_plist < 0) return;
+        bool plain_file = H5Pget_driver(access_plist) == H5FD_SEC2;
+        H5Pclose(access_plist);
+        if (!plain_file) return;
+    }
+
+    size_t elements = 1;
+    for (hsize_t extent : entry.dims) elements *= extent;
+    haddr_t address = H5Dget_offset(entry.dataset);
+    if (elements == 0 || address == HADDR_UNDEF || H5Dget_storage_size(entry.dataset) != elements * sizeof(double)) return;
+
+    // Dataset addresses are relative to the end of the user block
+    hsize_t userblock = 0;
+    hid_t file_create_plist = H5Fget_create_plist(file);
+    if (file_create_plist >= 0) {
+        H5Pget_userblock(file_create_plist, &userblock);
+        H5Pclose(file_create_plist);
+    }
+
+    uint64_t offset = address + userblock;
+    if (image) {
+        // File images are read in place, as long as the values are aligned
+        if (offset + elements * sizeof(double) > image->size() || (reinterpret_cast<uintptr_t>(image->data()) + offset) % alignof(double) != 0) return;
+        entry.image = image;
+        entry.mapped = reinterpret_cast<const double*>(image->data() + offset);
+        return;
+    }
+
+    std::error_code ec;
+    uintmax_t file_size = std::filesystem::file_size(file_path, ec);
+    if (ec || offset + elements * sizeof(double) > file_size) return;
+
+    try {
+        entry.mapping = std::make_unique<MappedRegion>(file_path, offset, elements * sizeof(double));
+        entry.mapped = static_cast<const double*>(entry.mapping->data());
+    } catch (const std::exception&) {
+        // Fall back to regular reads
+        entry.mapping.reset();
+        entry.mapped = nullptr;
+    }
+}
+
+hid_t H5FileReader::copyDataspace(const DatasetEntry& entry, const std::string& name) {
+    hid_t dataspace = H5Scopy(entry.dataspace);
+    if (dataspace < 0) {
+        throw std::runtime_error("Failed to get dataspace for dataset: " + name);
+    }
+    return dataspace;
+}
+
+std::vector<double> H5FileReader::readMatrixAxisFromDataset(const std::string& name) {
+    H5_STATS_OPERATION(H5Operation::Read, 0);
+    auto entry = openDataset(name);
+    if (entry->dims.size() != 1) {
+        throw std::invalid_argument("Dataset is not a vector: " + name);
+    }
+
+    std::vector<double> axis(entry->dims[0]);
+    if (entry->mapped) {
+        std::copy(entry->mapped, entry->mapped + axis.size(), axis.begin());
+        return axis;
+    }
+    H5_STATS_LIBRARY(H5Dread(entry->dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, axis.data()));
     return axis;
 }
 
 double H5FileReader::readScalarFromDataset(const std::string& name) {
-    hid_t dataset = H5Dopen(file, name.c_str(), H5P_DEFAULT);
-    if (dataset < 0) throw std::runtime_error("Failed to open dataset: " + name);
+    H5_STATS_OPERATION(H5Operation::Read, sizeof(double));
+    auto entry = openDataset(name);
+    hsize_t elements = 1;
+    for (hsize_t extent : entry->dims) elements *= extent;
+    if (elements != 1) {
+        throw std::invalid_argument("Dataset is not a scalar: " + name);
+    }
 
     double value;
-    H5Dread(dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, &value);
-    H5Dclose(dataset);
+    H5_STATS_LIBRARY(H5Dread(entry->dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, &value));
     return value;
 }
 
-std::vector<std::vector<double>> H5FileReader::read2DSliceFromMatrix(const std::string& name, int i, int j) {
-    std::vector<std::vector<double>> slice;
+std::map<std::string, double> H5FileReader::readDictionaryFromDataset(const std::string& name) {
+    return *loadDictionary(name);
+}
 
-    // Open the dataset
-    hid_t dataset = H5Dopen(file, name.c_str(), H5P_DEFAULT);
-    if (dataset < 0) {
-        throw std::runtime_error("Failed to open dataset: " + name);
+double H5FileReader::readScalarFromDictionary(const std::string& name, const std::string& key) {
+    auto dictionary = loadDictionary(name);
+    auto it = dictionary->find(key);
+    if (it == dictionary->end()) {
+        throw std::out_of_range("Key " + key + " not found in dictionary: " + name);
+    }
+    return it->second;
+}
+
+std::shared_ptr<const std::map<std::string, double>> H5FileReader::loadDictionary(const std::string& name) {
+    {
+        std::lock_guard<std::mutex> lock(dictionary_mutex);
+        auto it = dictionary_cache.find(name);
+        if (it != dictionary_cache.end()) {
+            return it->second;
+        }
     }
 
-    // Get the dataspace
-    hid_t dataspace = H5Dget_space(dataset);
-    if (dataspace < 0) {
-        H5Dclose(dataset);
-        throw std::runtime_error("Failed to get dataspace for dataset: " + name);
+    H5_STATS_OPERATION(H5Operation::Read, 0);
+    auto dictionary = std::make_shared<std::map<std::string, double>>();
+
+    if (H5Lexists(file, name.c_str(), H5P_DEFAULT) > 0) {
+        // Table layout: one compound read
+        auto entry = openDataset(name);
+        hid_t file_type = H5Dget_type(entry->dataset);
+        bool table = file_type >= 0 && H5Tget_class(file_type) == H5T_COMPOUND;
+        int key_member = table ? H5Tget_member_index(file_type, "key") : -1;
+        if (!table || key_member < 0 || entry->dims.size() != 1) {
+            if (file_type >= 0) H5Tclose(file_type);
+            throw std::invalid_argument("Dataset is not a dictionary table: " + name);
+        }
+        hid_t file_key_type = H5Tget_member_type(file_type, key_member);
+        const size_t key_size = H5Tget_size(file_key_type);
+        H5Tclose(file_key_type);
+        H5Tclose(file_type);
+
+        const size_t row_size = key_size + sizeof(double);
+        hid_t key_type = H5Tcopy(H5T_C_S1);
+        H5Tset_size(key_type, key_size);
+        H5Tset_strpad(key_type, H5T_STR_NULLTERM);
+        hid_t row_type = H5Tcreate(H5T_COMPOUND, row_size);
+        H5Tinsert(row_type, "key", 0, key_type);
+        H5Tinsert(row_type, "value", key_size, H5T_NATIVE_DOUBLE);
+        H5Tclose(key_type);
+
+        std::vector<char> rows(entry->dims[0] * row_size);
+        herr_t status = rows.empty() ? 0 : H5_STATS_LIBRARY(H5Dread(entry->dataset, row_type, H5S_ALL, H5S_ALL, H5P_DEFAULT, rows.data()));
+        H5Tclose(row_type);
+        if (status < 0) {
+            throw std::runtime_error("Failed to read dictionary table: " + name);
+        }
+
+        for (size_t row = 0; row < entry->dims[0]; ++row) {
+            const char* key = rows.data() + row * row_size;
+            double value;
+            std::memcpy(&value, key + key_size, sizeof(double));
+            (*dictionary)[std::string(key, strnlen(key, key_size))] = value;
+        }
+    } else {
+        // Per-key layout: collect <name>_<key> datasets from the root group. Only single
+        // floating point values qualify, so axes or matrices sharing the prefix are skipped.
+        std::pair<std::string, std::vector<std::string>> search{name + "_", {}};
+        H5Literate(file, H5_INDEX_NAME, H5_ITER_NATIVE, nullptr, [](hid_t group, const char* link, const H5L_info_t*, void* data) -> herr_t {
+            auto* found = static_cast<std::pair<std::string, std::vector<std::string>>*>(data);
+            if (std::strncmp(link, found->first.c_str(), found->first.size()) != 0) {
+                return 0;
+            }
+            hid_t object = H5Oopen(group, link, H5P_DEFAULT);
+            if (object < 0) return 0;
+            if (H5Iget_type(object) == H5I_DATASET) {
+                hid_t space = H5Dget_space(object);
+                hid_t type = H5Dget_type(object);
+                if (space >= 0 && type >= 0 && H5Sget_simple_extent_npoints(space) == 1 && H5Tget_class(type) == H5T_FLOAT) {
+                    found->second.push_back(link);
+                }
+                if (space >= 0) H5Sclose(space);
+                if (type >= 0) H5Tclose(type);
+            }
+            H5Oclose(object);
+            return 0;
+        }, &search);
+        if (search.second.empty()) {
+            throw std::runtime_error("Failed to open dictionary: " + name);
+        }
+        for (auto& link : search.second) {
+            (*dictionary)[link.substr(search.first.size())] = readScalarFromDataset(link);
+        }
     }
 
-    // Get the dimensions of the dataset
-    hsize_t dims_out[4];
-    H5Sget_simple_extent_dims(dataspace, dims_out, nullptr);
+    std::lock_guard<std::mutex> lock(dictionary_mutex);
+    auto it = dictionary_cache.emplace(name, std::move(dictionary)).first;
+    return it->second;
+}
+
+std::vector<std::vector<double>> H5FileReader::read2DSliceFromMatrix(const std::string& name, int i, int j) {
+    std::vector<std::vector<double>> slice;
+
+    auto entry = openDataset(name);
+    const std::vector<hsize_t>& dims_out = entry->dims;
+    if (dims_out.size() != 4) {
+        throw std::invalid_argument("Dataset is not a 4D matrix: " + name);
+    }
 
     // Ensure i and j are within bounds
     if (i < 0 || i >= dims_out[2] || j < 0 || j >= dims_out[3]) {
-        H5Sclose(dataspace);
-        H5Dclose(dataset);
         throw std::out_of_range("Indices i or j are out of bounds");
     }
 
-    // Prepare the output slice
-    hsize_t slice_dims[2] = {dims_out[0], dims_out[1]};
-    std::vector<double> buffer(slice_dims[0] * slice_dims[1]);
+    std::vector<double> buffer;
+    SliceView view = readSlice(name, {0, 1}, {0, 0, static_cast<hsize_t>(i), static_cast<hsize_t>(j)}, buffer);
 
-    // Define hyperslab
-    hsize_t offset[4] = {0, 0, static_cast<hsize_t>(i), static_cast<hsize_t>(j)};
-    hsize_t count[4] = {slice_dims[0], slice_dims[1], 1, 1};
-    H5Sselect_hyperslab(dataspace, H5S_SELECT_SET, offset, nullptr, count, nullptr);
+    // Convert the contiguous slice into a 2D vector
+    slice.resize(view.extents[0], std::vector<double>(view.extents[1]));
+    for (size_t row = 0; row < view.extents[0]; ++row) {
+        std::copy(view.data + row * view.strides[0],
+                view.data + row * view.strides[0] + view.extents[1],
+                slice[row].begin());
+    }
 
-    // Define memory space for the slice
-    hid_t memspace = H5Screate_simple(2, slice_dims, nullptr);
-    if (memspace < 0) {
-        H5Sclose(dataspace);
-        H5Dclose(dataset);
-        throw std::runtime_error("Failed to create memory dataspace for reading");
+    return slice;
+}
+
+SliceView H5FileReader::readSlice(const std::string& name, const std::vector<int>& axes, const std::vector<hsize_t>& index, std::vector<double>& buffer) {
+    auto entry = openDataset(name);
+    size_t elements = 1;
+    for (int axis : axes) {
+        if (axis < 0 || static_cast<size_t>(axis) >= entry->dims.size()) {
+            throw std::out_of_range("Slice axis is out of range for dataset: " + name);
+        }
+        elements *= entry->dims[axis];
     }
+    if (buffer.size() < elements) {
+        buffer.resize(elements);
+    }
+    return readSlice(name, axes, index, buffer.data());
+}
 
-    // Read the hyperslab into the buffer
-    H5Dread(dataset, H5T_NATIVE_DOUBLE, memspace, dataspace, H5P_DEFAULT, buffer.data());
+SliceView H5FileReader::readSlice(const std::string& name, const std::vector<int>& axes, const std::vector<hsize_t>& index, double* out) {
+    H5_STATS_OPERATION(H5Operation::Read, 0);
+    auto entry = openDataset(name);
+    const std::vector<hsize_t>& dims = entry->dims;
+    const int rank = static_cast<int>(dims.size());
+    const int slice_rank = static_cast<int>(axes.size());
+    if (index.size() != dims.size()) {
+        throw std::invalid_argument("Slice index does not match the rank of dataset: " + name);
+    }
+    if (slice_rank == 0 || slice_rank > SliceView::max_rank || slice_rank > rank) {
+        throw std::invalid_argument("Unsupported slice rank for dataset: " + name);
+    }
 
-    // Convert the 1D buffer into a 2D vector
-    slice.resize(slice_dims[0], std::vector<double>(slice_dims[1]));
-    for (size_t row = 0; row < slice_dims[0]; ++row) {
-        std::copy(buffer.begin() + row * slice_dims[1],
-                buffer.begin() + (row + 1) * slice_dims[1],
-                slice[row].begin());
+    // Fixed axes select one index, free axes span the whole extent
+    hsize_t offset[H5S_MAX_RANK];
+    hsize_t count[H5S_MAX_RANK];
+    bool free_axis[H5S_MAX_RANK] = {};
+    for (int axis : axes) {
+        if (axis < 0 || axis >= rank || free_axis[axis]) {
+            throw std::out_of_range("Slice axes are out of range or repeated for dataset: " + name);
+        }
+        free_axis[axis] = true;
+    }
+    for (int d = 0; d < rank; ++d) {
+        if (free_axis[d]) {
+            offset[d] = 0;
+            count[d] = dims[d];
+        } else {
+            if (index[d] >= dims[d]) {
+                throw std::out_of_range("Slice index is out of bounds for dataset: " + name);
+            }
+            offset[d] = index[d];
+            count[d] = 1;
+        }
     }
 
-    // Close resources
-    H5Sclose(memspace);
-    H5Sclose(dataspace);
-    H5Dclose(dataset);
+    // Readahead steps along the innermost fixed axis, the one a sweep of slices moves along
+    int readahead_axis = -1;
+    for (int d = 0; d < rank; ++d) {
+        if (!free_axis[d]) readahead_axis = d;
+    }
+    readCachedBlock(*entry, name, offset, count, out, readahead_axis);
+
+    // Data arrives in file order; the view puts the axes in the order asked for
+    hsize_t file_strides[H5S_MAX_RANK];
+    hsize_t stride = 1;
+    for (int d = rank; d-- > 0;) {
+        file_strides[d] = stride;
+        stride *= count[d];
+    }
 
-    return slice;
+    SliceView view;
+    view.data = out;
+    view.rank = slice_rank;
+    for (int n = 0; n < slice_rank; ++n) {
+        view.extents[n] = dims[axes[n]];
+        view.strides[n] = file_strides[axes[n]];
+    }
+    return view;
 }
 
 double H5FileReader::readPointFromMatrix(const std::string& name, int i, int j, int k, int l) {
-    // Open the dataset
-    hid_t dataset = H5Dopen(file, name.c_str(), H5P_DEFAULT);
-    if (dataset < 0) {
-        throw std::runtime_error("Failed to open dataset: " + name);
-    }
+    H5_STATS_OPERATION(H5Operation::Read, sizeof(double));
 
-    // Get the dataspace
-    hid_t dataspace = H5Dget_space(dataset);
-    if (dataspace < 0) {
-        H5Dclose(dataset);
-        throw std::runtime_error("Failed to get dataspace for dataset: " + name);
+    auto entry = openDataset(name);
+    const std::vector<hsize_t>& dims_out = entry->dims;
+    if (dims_out.size() != 4) {
+        throw std::invalid_argument("Dataset is not a 4D matrix: " + name);
     }
 
-    // Get the dimensions of the dataset
-    hsize_t dims_out[4];
-    H5Sget_simple_extent_dims(dataspace, dims_out, nullptr);
-
     // Ensure i, j, k, and l are within bounds
     if (i < 0 || i >= dims_out[0] || j < 0 || j >= dims_out[1] || k < 0 || k >= dims_out[2] || l < 0 || l >= dims_out[3]) {
-        H5Sclose(dataspace);
-        H5Dclose(dataset);
         throw std::out_of_range("Indices i, j, k, or l are out of bounds");
     }
 
-    // Define hyperslab
+    if (entry->mapped) {
+        return entry->mapped[((static_cast<size_t>(i) * dims_out[1] + j) * dims_out[2] + k) * dims_out[3] + l];
+    }
+
     hsize_t offset[4] = {static_cast<hsize_t>(i), static_cast<hsize_t>(j), static_cast<hsize_t>(k), static_cast<hsize_t>(l)};
     hsize_t count[4] = {1, 1, 1, 1};
+    if (block_cache.load()) {
+        double point;
+        readCachedBlock(*entry, name, offset, count, &point, 3);
+        return point;
+    }
+
+    // Define hyperslab
+    hid_t dataspace = copyDataspace(*entry, name);
     H5Sselect_hyperslab(dataspace, H5S_SELECT_SET, offset, nullptr, count, nullptr);
 
     // Define memory space for the point
     hid_t memspace = H5Screate_simple(1, count, nullptr);
     if (memspace < 0) {
         H5Sclose(dataspace);
-        H5Dclose(dataset);
         throw std::runtime_error("Failed to create memory dataspace for reading");
     }
 
     // Read the hyperslab into the buffer
     double point;
-    H5Dread(dataset, H5T_NATIVE_DOUBLE, memspace, dataspace, H5P_DEFAULT, &point);
+    readValues(*entry, memspace, dataspace, 1, &point);
 
     // Close resources
     H5Sclose(memspace);
     H5Sclose(dataspace);
-    H5Dclose(dataset);
 
     return point;
 }
 
 double H5FileReader::readPointFromVector(const std::string& name, int i) {
-    // Open the dataset
-    hid_t dataset = H5Dopen(file, name.c_str(), H5P_DEFAULT);
-    if (dataset < 0) {
-        throw std::runtime_error("Failed to open dataset: " + name);
-    }
+    H5_STATS_OPERATION(H5Operation::Read, sizeof(double));
 
-    // Get the dataspace
-    hid_t dataspace = H5Dget_space(dataset);
-    if (dataspace < 0) {
-        H5Dclose(dataset);
-        throw std::runtime_error("Failed to get dataspace for dataset: " + name);
+    auto entry = openDataset(name);
+    const std::vector<hsize_t>& dims_out = entry->dims;
+    if (dims_out.size() != 1) {
+        throw std::invalid_argument("Dataset is not a vector: " + name);
     }
 
-    // Get the dimensions of the dataset
-    hsize_t dims_out[1];
-    H5Sget_simple_extent_dims(dataspace, dims_out, nullptr);
-
     // Ensure the index is within bounds
     if (i < 0 || i >= dims_out[0]) {
-        H5Sclose(dataspace);
-        H5Dclose(dataset);
         throw std::out_of_range("Index i is out of bounds");
     }
 
+    if (entry->mapped) {
+        return entry->mapped[i];
+    }
+
     // Define hyperslab
+    hid_t dataspace = copyDataspace(*entry, name);
     hsize_t offset[1] = {static_cast<hsize_t>(i)};
     hsize_t count[1] = {1};  // Only one point at index i
     H5Sselect_hyperslab(dataspace, H5S_SELECT_SET, offset, nullptr, count, nullptr);
@@ -404,60 +1982,520 @@ double H5FileReader::readPointFromVector(const std::string& name, int i) {
     hid_t memspace = H5Screate_simple(1, count, nullptr);
     if (memspace < 0) {
         H5Sclose(dataspace);
-        H5Dclose(dataset);
         throw std::runtime_error("Failed to create memory dataspace");
     }
 
     // Read the hyperslab into the buffer
     double point;
-    H5Dread(dataset, H5T_NATIVE_DOUBLE, memspace, dataspace, H5P_DEFAULT, &point);
+    readValues(*entry, memspace, dataspace, 1, &point);
 
     // Close resources
     H5Sclose(memspace);
     H5Sclose(dataspace);
-    H5Dclose(dataset);
 
     return point;
 }
 
+std::vector<double> H5FileReader::readPointsFromMatrix(const std::string& name, const std::vector<hsize_t>& coords) {
+    auto entry = openDataset(name);
+    const size_t rank = entry->dims.size();
+    if (rank == 0 || coords.size() % rank != 0) {
+        throw std::invalid_argument("Coordinates do not match the rank of dataset: " + name);
+    }
 
-double H5FileReader::getMinimumFromMatrix(const std::string& name) {
-    double min_value = std::numeric_limits<double>::max();
+    std::vector<double> points(coords.size() / rank);
+    readPointsFromMatrix(name, coords.data(), points.size(), points.data());
+    return points;
+}
 
-    // Open the dataset
-    hid_t dataset = H5Dopen(file, name.c_str(), H5P_DEFAULT);
-    if (dataset < 0) {
-        throw std::runtime_error("Failed to open dataset: " + name);
+void H5FileReader::readPointsFromMatrix(const std::string& name, const hsize_t* coords, size_t count, double* out) {
+    H5_STATS_OPERATION(H5Operation::Read, count * sizeof(double));
+    if (count == 0) return;
+
+    auto entry = openDataset(name);
+    const std::vector<hsize_t>& dims = entry->dims;
+    const size_t rank = dims.size();
+    checkCoordinates(coords, count, dims);
+
+    if (entry->mapped) {
+        for (size_t n = 0; n < count; ++n) {
+            size_t index = 0;
+            for (size_t d = 0; d < rank; ++d) {
+                index = index * dims[d] + coords[n * rank + d];
+            }
+            out[n] = entry->mapped[index];
+        }
+        return;
     }
 
-    // Get the dataspace
-    hid_t dataspace = H5Dget_space(dataset);
-    if (dataspace < 0) {
-        H5Dclose(dataset);
-        throw std::runtime_error("Failed to get dataspace for dataset: " + name);
+    if (block_cache.load()) {
+        // Gather from cached blocks, reusing the last block while points stay inside it
+        const std::vector<hsize_t>& block = entry->cache_block;
+        H5BlockCache::Key key{file_identity, name, 0};
+        std::vector<hsize_t> position(rank);
+        H5BlockCache::Block current;
+        uint64_t current_index = 0;
+        for (size_t n = 0; n < count; ++n) {
+            uint64_t index = 0;
+            size_t within = 0;
+            for (size_t d = 0; d < rank; ++d) {
+                const hsize_t coordinate = coords[n * rank + d];
+                position[d] = coordinate / block[d];
+                index = index * ((dims[d] + block[d] - 1) / block[d]) + position[d];
+                within = within * std::min(block[d], dims[d] - position[d] * block[d]) + coordinate % block[d];
+            }
+            if (!current || index != current_index) {
+                key.block = index;
+                current = fetchBlock(*entry, key, position, static_cast<int>(rank) - 1);
+                current_index = index;
+            }
+            out[n] = (*current)[within];
+        }
+        return;
     }
 
-    // Get the dimensions of the dataset
-    hsize_t dims_out[4];
-    H5Sget_simple_extent_dims(dataspace, dims_out, nullptr);
+    // Sort by file position to find unique points and contiguous runs along the last axis
+    std::vector<hsize_t> linear(count);
+    for (size_t n = 0; n < count; ++n) {
+        hsize_t index = 0;
+        for (size_t d = 0; d < rank; ++d) {
+            index = index * dims[d] + coords[n * rank + d];
+        }
+        linear[n] = index;
+    }
+    std::vector<size_t> order(count);
+    for (size_t n = 0; n < count; ++n) order[n] = n;
+    std::sort(order.begin(), order.end(), [&linear](size_t a, size_t b) { return linear[a] < linear[b]; });
+
+    size_t unique = 0;
+    size_t runs = 0;
+    for (size_t n = 0; n < count; ++n) {
+        hsize_t index = linear[order[n]];
+        if (n > 0 && index == linear[order[n - 1]]) continue;
+        bool extends_run = unique > 0 && index == linear[order[n - 1]] + 1 && coords[order[n] * rank + rank - 1] != 0;
+        if (!extends_run) runs++;
+        unique++;
+    }
+
+    hid_t dataspace = copyDataspace(*entry, name);
+    herr_t status = 0;
+    hsize_t elements;
+    std::vector<double> buffer;
+    const bool coalesce = runs * 8 <= unique;
+    if (!coalesce) {
+        // One element selection, values come back in caller order
+        elements = count;
+        status = H5Sselect_elements(dataspace, H5S_SELECT_SET, count, coords);
+    } else {
+        // Dense batches read as a union of row runs, values come back in file order
+        elements = unique;
+        buffer.resize(unique);
+        H5Sselect_none(dataspace);
+        std::vector<hsize_t> start(rank), block(rank, 1);
+        for (size_t n = 0; n < count && status >= 0;) {
+            size_t first = order[n];
+            hsize_t length = 1;
+            size_t next = n + 1;
+            while (next < count) {
+                hsize_t index = linear[order[next]];
+                hsize_t last = linear[first] + length - 1;
+                if (index == last) {
+                    next++;
+                } else if (index == last + 1 && coords[order[next] * rank + rank - 1] != 0) {
+                    length++;
+                    next++;
+                } else {
+                    break;
+                }
+            }
+            std::copy(coords + first * rank, coords + (first + 1) * rank, start.begin());
+            block[rank - 1] = length;
+            status = H5Sselect_hyperslab(dataspace, H5S_SELECT_OR, start.data(), nullptr, block.data(), nullptr);
+            n = next;
+        }
+    }
 
-    // Prepare the output buffer
-    size_t total_elements = dims_out[0] * dims_out[1] * dims_out[2] * dims_out[3];
-    std::vector<double> buffer(total_elements);
+    hid_t memspace = H5Screate_simple(1, &elements, nullptr);
+    if (status < 0 || memspace < 0) {
+        if (memspace >= 0) H5Sclose(memspace);
+        H5Sclose(dataspace);
+        throw std::runtime_error("Failed to select points in dataset: " + name);
+    }
 
-    // Read the data into the buffer
-    H5Dread(dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, buffer.data());
+    status = readValues(*entry, memspace, dataspace, elements, coalesce ? buffer.data() : out);
+    H5Sclose(memspace);
+    H5Sclose(dataspace);
+    if (status < 0) {
+        throw std::runtime_error("Failed to read points from dataset: " + name);
+    }
 
-    // Find the minimum value in the buffer
-    for (const auto& value : buffer) {
-        if (value < min_value) {
-            min_value = value;
+    // Scatter the unique values back to caller order
+    if (coalesce) {
+        size_t position = 0;
+        for (size_t n = 0; n < count; ++n) {
+            if (n > 0 && linear[order[n]] != linear[order[n - 1]]) position++;
+            out[order[n]] = buffer[position];
         }
     }
+}
 
-    // Close resources
+
+double H5FileReader::getMinimumFromMatrix(const std::string& name) {
+    // As before the reduction: DBL_MAX when no value lies below it, NaN included
+    const double min = reduceMatrix(name).min;
+    return min < std::numeric_limits<double>::max() ? min : std::numeric_limits<double>::max();
+}
+
+std::vector<hsize_t> H5FileReader::getMatrixDims(const std::string& name) {
+    return openDataset(name)->dims;
+}
+
+void H5FileReader::readMatrix(const std::string& name, double* out) {
+    H5_STATS_OPERATION(H5Operation::Read, 0);
+    auto entry = openDataset(name);
+    std::vector<hsize_t> offset(entry->dims.size(), 0);
+    readBlock(*entry, name, offset.data(), entry->dims.data(), out);
+}
+
+std::vector<hsize_t> H5FileReader::readBlockShape(const DatasetEntry& entry, size_t max_elements) const {
+    if (entry.chunk.empty()) {
+        return blockShape(entry.dims, max_elements);
+    }
+
+    // Whole chunks, widened from the trailing axis while the budget allows
+    std::vector<hsize_t> shape = entry.chunk;
+    hsize_t elements = 1;
+    for (hsize_t extent : shape) elements *= extent;
+    for (size_t d = shape.size(); d-- > 0;) {
+        hsize_t factor = std::max<hsize_t>(max_elements / elements, 1);
+        hsize_t widened = std::min(entry.dims[d], shape[d] * factor);
+        if (widened > shape[d]) {
+            elements = elements / shape[d] * widened;
+            shape[d] = widened;
+        }
+    }
+    return shape;
+}
+
+herr_t H5FileReader::readValues(const DatasetEntry& entry, hid_t memspace, hid_t dataspace, size_t count, double* out) {
+    if (entry.storage == StorageType::Float32) {
+        thread_local std::vector<float> narrowed;
+        if (narrowed.size() < count) narrowed.resize(count);
+        herr_t status = H5_STATS_LIBRARY(H5Dread(entry.dataset, H5T_NATIVE_FLOAT, memspace, dataspace, H5P_DEFAULT, narrowed.data()));
+        if (status >= 0) std::copy(narrowed.begin(), narrowed.begin() + count, out);
+        return status;
+    }
+    if (isScaled(entry.storage)) {
+        thread_local std::vector<int32_t> codes;
+        if (codes.size() < count) codes.resize(count);
+        herr_t status = H5_STATS_LIBRARY(H5Dread(entry.dataset, H5T_NATIVE_INT32, memspace, dataspace, H5P_DEFAULT, codes.data()));
+        if (status >= 0) entry.quantisation.decode(codes.data(), count, out);
+        return status;
+    }
+    return H5_STATS_LIBRARY(H5Dread(entry.dataset, H5T_NATIVE_DOUBLE, memspace, dataspace, H5P_DEFAULT, out));
+}
+
+void H5FileReader::readBlock(const DatasetEntry& entry, const std::string& name, const hsize_t* offset, const hsize_t* count, double* out) {
+    const int rank = static_cast<int>(entry.dims.size());
+    if (rank == 0) {
+        if (readValues(entry, H5S_ALL, H5S_ALL, 1, out) < 0) {
+            throw std::runtime_error("Failed to read dataset: " + name);
+        }
+        return;
+    }
+
+    if (entry.mapped) {
+        // Copy rows of the trailing axis straight out of the mapping
+        const size_t row = count[rank - 1];
+        size_t rows = 1;
+        for (int d = 0; d < rank - 1; ++d) rows *= count[d];
+        for (size_t n = 0; n < rows; ++n) {
+            size_t remainder = n;
+            size_t source = 0;
+            size_t scale = 1;
+            for (int d = rank - 1; d >= 0; --d) {
+                size_t position = d == rank - 1 ? offset[d] : offset[d] + remainder % count[d];
+                if (d < rank - 1) remainder /= count[d];
+                source += position * scale;
+                scale *= entry.dims[d];
+            }
+            std::copy(entry.mapped + source, entry.mapped + source + row, out + n * row);
+        }
+        return;
+    }
+
+    hid_t dataspace = copyDataspace(entry, name);
+    hid_t memspace = H5Screate_simple(rank, count, nullptr);
+    if (memspace < 0 || H5Sselect_hyperslab(dataspace, H5S_SELECT_SET, offset, nullptr, count, nullptr) < 0) {
+        if (memspace >= 0) H5Sclose(memspace);
+        H5Sclose(dataspace);
+        throw std::runtime_error("Failed to select block in dataset: " + name);
+    }
+
+    size_t elements = 1;
+    for (int d = 0; d < rank; ++d) elements *= count[d];
+    herr_t status = readValues(entry, memspace, dataspace, elements, out);
+    H5Sclose(memspace);
     H5Sclose(dataspace);
-    H5Dclose(dataset);
+    if (status < 0) {
+        throw std::runtime_error("Failed to read block from dataset: " + name);
+    }
+}
 
-    return min_value;
+void H5FileReader::readCachedBlock(const DatasetEntry& entry, const std::string& name, const hsize_t* offset, const hsize_t* count, double* out, int readahead_axis) {
+    const int rank = static_cast<int>(entry.dims.size());
+    if (!block_cache.load() || entry.mapped || rank == 0) {
+        readBlock(entry, name, offset, count, out);
+        return;
+    }
+
+    const std::vector<hsize_t>& dims = entry.dims;
+    const std::vector<hsize_t>& block = entry.cache_block;
+    std::vector<hsize_t> first(rank), last(rank), position(rank);
+    for (int d = 0; d < rank; ++d) {
+        first[d] = offset[d] / block[d];
+        last[d] = (offset[d] + count[d] - 1) / block[d];
+    }
+
+    // Visit every block the hyperslab touches and copy the overlap row by row
+    H5BlockCache::Key key{file_identity, name, 0};
+    position = first;
+    for (;;) {
+        uint64_t index = 0;
+        for (int d = 0; d < rank; ++d) {
+            index = index * ((dims[d] + block[d] - 1) / block[d]) + position[d];
+        }
+        key.block = index;
+        H5BlockCache::Block values = fetchBlock(entry, key, position, readahead_axis);
+
+        hsize_t origin[H5S_MAX_RANK], extent[H5S_MAX_RANK], low[H5S_MAX_RANK], high[H5S_MAX_RANK];
+        size_t overlap_rows = 1;
+        for (int d = 0; d < rank; ++d) {
+            origin[d] = position[d] * block[d];
+            extent[d] = std::min(block[d], dims[d] - origin[d]);
+            low[d] = std::max(origin[d], offset[d]);
+            high[d] = std::min(origin[d] + extent[d], offset[d] + count[d]);
+            if (d < rank - 1) overlap_rows *= high[d] - low[d];
+        }
+        const size_t row = high[rank - 1] - low[rank - 1];
+        for (size_t n = 0; n < overlap_rows; ++n) {
+            size_t remainder = n;
+            size_t source = 0, target = 0, source_scale = 1, target_scale = 1;
+            for (int d = rank - 1; d >= 0; --d) {
+                hsize_t coordinate = low[d];
+                if (d < rank - 1) {
+                    coordinate += remainder % (high[d] - low[d]);
+                    remainder /= high[d] - low[d];
+                }
+                source += (coordinate - origin[d]) * source_scale;
+                target += (coordinate - offset[d]) * target_scale;
+                source_scale *= extent[d];
+                target_scale *= count[d];
+            }
+            std::copy(values->data() + source, values->data() + source + row, out + target);
+        }
+
+        int d = rank;
+        while (d-- > 0) {
+            if (++position[d] <= last[d]) break;
+            position[d] = first[d];
+        }
+        if (d < 0) break;
+    }
+}
+
+H5BlockCache::Block H5FileReader::fetchBlock(const DatasetEntry& entry, H5BlockCache::Key& key, const std::vector<hsize_t>& position, int readahead_axis) {
+    H5BlockCache& cache = *block_cache.load();
+    H5BlockCache::Block values = cache.find(key);
+    if (values) {
+        return values;
+    }
+
+    const int rank = static_cast<int>(entry.dims.size());
+    const std::vector<hsize_t>& dims = entry.dims;
+    const std::vector<hsize_t>& block = entry.cache_block;
+
+    // Extend the read over following blocks along the readahead axis that are not cached yet
+    size_t run = 1;
+    hsize_t stride = 1; // Linear block index step along the readahead axis
+    if (readahead_axis >= 0) {
+        for (int d = rank - 1; d > readahead_axis; --d) stride *= (dims[d] + block[d] - 1) / block[d];
+        const hsize_t grid = (dims[readahead_axis] + block[readahead_axis] - 1) / block[readahead_axis];
+        const size_t limit = readahead_blocks.load();
+        H5BlockCache::Key next = key;
+        while (run <= limit && position[readahead_axis] + run < grid) {
+            next.block = key.block + run * stride;
+            if (cache.contains(next)) break;
+            run++;
+        }
+    }
+
+    std::vector<hsize_t> offset(rank), count(rank);
+    for (int d = 0; d < rank; ++d) {
+        offset[d] = position[d] * block[d];
+        count[d] = std::min(block[d], dims[d] - offset[d]);
+    }
+    if (run > 1) {
+        count[readahead_axis] = std::min<hsize_t>(run * block[readahead_axis], dims[readahead_axis] - offset[readahead_axis]);
+    }
+    size_t elements = 1;
+    for (int d = 0; d < rank; ++d) elements *= count[d];
+    std::vector<double> region(elements);
+    readBlock(entry, key.dataset, offset.data(), count.data(), region.data());
+
+    if (run == 1) {
+        values = std::make_shared<const std::vector<double>>(std::move(region));
+        cache.insert(key, values);
+        return values;
+    }
+
+    // Split the region into its blocks; leading axes form the outer rows
+    size_t outer = 1, inner = 1;
+    for (int d = 0; d < readahead_axis; ++d) outer *= count[d];
+    for (int d = readahead_axis + 1; d < rank; ++d) inner *= count[d];
+    for (size_t b = 0; b < run; ++b) {
+        const hsize_t start = b * block[readahead_axis];
+        const hsize_t extent = std::min(block[readahead_axis], count[readahead_axis] - start);
+        auto part = std::make_shared<std::vector<double>>(outer * extent * inner);
+        for (size_t o = 0; o < outer; ++o) {
+            const double* source = region.data() + (o * count[readahead_axis] + start) * inner;
+            std::copy(source, source + extent * inner, part->data() + o * extent * inner);
+        }
+        H5BlockCache::Key part_key = key;
+        part_key.block = key.block + b * stride;
+        cache.insert(part_key, part, b > 0);
+        if (b == 0) values = part;
+    }
+    return values;
+}
+
+MatrixStatistics H5FileReader::reduceMatrix(const std::string& name, size_t block_elements) {
+    auto entry = openDataset(name);
+    const std::vector<hsize_t>& dims = entry->dims;
+    const size_t rank = dims.size();
+
+    MatrixStatistics stats;
+    size_t total_elements = 1;
+    for (hsize_t extent : dims) total_elements *= extent;
+    if (total_elements == 0) return stats;
+
+    ThreadPool& pool = ThreadPool::shared();
+    // Called from a task of the shared pool the partials run inline, waiting on them could deadlock the pool
+    const bool on_worker = pool.onWorkerThread();
+    auto reduceAsync = [&pool, on_worker](const double* data, size_t begin, size_t end) {
+        auto task = [data, begin, end]() { return reduceRange(data, begin, end); };
+        return on_worker ? std::async(std::launch::deferred, task) : pool.submit(task);
+    };
+    auto merge = [&stats](const BlockReduction& result, const std::function<std::vector<hsize_t>(size_t)>& locate) {
+        stats.nan_count += result.nan;
+        if (result.ordered == 0) return;
+        if (std::isnan(stats.min) || result.min < stats.min) {
+            stats.min = result.min;
+            stats.argmin = locate(result.argmin);
+        }
+        if (std::isnan(stats.max) || result.max > stats.max) {
+            stats.max = result.max;
+            stats.argmax = locate(result.argmax);
+        }
+        stats.sum += result.sum;
+        stats.finite_count += result.finite;
+    };
+
+    // Memory mapped data is reduced in place, no reads or buffers needed
+    if (entry->mapped) {
+        H5_STATS_OPERATION(H5Operation::Read, total_elements * sizeof(double));
+        const double* data = entry->mapped;
+        auto locate = [&dims, rank](size_t position) {
+            std::vector<hsize_t> coordinates(rank);
+            for (size_t d = rank; d-- > 0;) {
+                coordinates[d] = position % dims[d];
+                position /= dims[d];
+            }
+            return coordinates;
+        };
+        size_t step = std::max<size_t>(block_elements, 16384);
+        std::vector<std::future<BlockReduction>> partials;
+        for (size_t begin = 0; begin < total_elements; begin += step) {
+            size_t end = std::min(total_elements, begin + step);
+            partials.push_back(reduceAsync(data, begin, end));
+        }
+        for (auto& partial : partials) {
+            merge(partial.get(), locate);
+        }
+        if (stats.finite_count > 0) {
+            stats.mean = stats.sum / stats.finite_count;
+        }
+        return stats;
+    }
+
+    // Walk the dataset in C-ordered blocks of at most block_elements
+    std::vector<hsize_t> block = readBlockShape(*entry, block_elements);
+    std::vector<hsize_t> grid(rank);
+    size_t block_count = 1;
+    for (size_t d = 0; d < rank; ++d) {
+        grid[d] = (dims[d] + block[d] - 1) / block[d];
+        block_count *= grid[d];
+    }
+    auto blockOrigin = [&](size_t index, std::vector<hsize_t>& offset, std::vector<hsize_t>& count) {
+        for (size_t d = rank; d-- > 0;) {
+            offset[d] = (index % grid[d]) * block[d];
+            count[d] = std::min(block[d], dims[d] - offset[d]);
+            index /= grid[d];
+        }
+    };
+
+    size_t buffer_elements = 1;
+    for (hsize_t extent : block) buffer_elements *= extent;
+    std::vector<double> buffers[2] = {std::vector<double>(buffer_elements), std::vector<double>(buffer_elements)};
+    std::vector<hsize_t> offsets[2] = {std::vector<hsize_t>(rank), std::vector<hsize_t>(rank)};
+    std::vector<hsize_t> counts[2] = {std::vector<hsize_t>(rank), std::vector<hsize_t>(rank)};
+
+    auto readInto = [&](size_t index, int slot) {
+        H5_STATS_OPERATION(H5Operation::Read, buffer_elements * sizeof(double));
+        blockOrigin(index, offsets[slot], counts[slot]);
+        readBlock(*entry, name, offsets[slot].data(), counts[slot].data(), buffers[slot].data());
+    };
+
+    auto locate = [&](int slot, size_t position) {
+        std::vector<hsize_t> coordinates(rank);
+        for (size_t d = rank; d-- > 0;) {
+            coordinates[d] = offsets[slot][d] + position % counts[slot][d];
+            position /= counts[slot][d];
+        }
+        return coordinates;
+    };
+
+    // Double buffering: the next block is read while the current one is reduced. One I/O
+    // thread serves the whole pass; declared after the buffers, it stops before they go.
+    ThreadPool io(1);
+    std::future<void> pending = io.submit([&]() { readInto(0, 0); });
+    for (size_t index = 0; index < block_count; ++index) {
+        const int slot = index % 2;
+        pending.get();
+        if (index + 1 < block_count) {
+            pending = io.submit([&, index, slot]() { readInto(index + 1, 1 - slot); });
+        }
+
+        size_t elements = 1;
+        for (hsize_t extent : counts[slot]) elements *= extent;
+        const double* data = buffers[slot].data();
+
+        size_t parts = std::min(pool.size(), elements / 16384 + 1);
+        std::vector<std::future<BlockReduction>> partials;
+        for (size_t part = 0; part < parts; ++part) {
+            size_t begin = elements * part / parts;
+            size_t end = elements * (part + 1) / parts;
+            partials.push_back(reduceAsync(data, begin, end));
+        }
+
+        // Merge in index order so ties keep the first occurrence
+        for (auto& partial : partials) {
+            merge(partial.get(), [&locate, slot](size_t position) { return locate(slot, position); });
+        }
+    }
+
+    if (stats.finite_count > 0) {
+        stats.mean = stats.sum / stats.finite_count;
+    }
+    return stats;
 }
\ No newline at end of file
@@ -2,6 +2,10 @@
 #define H5_H
 
 #include "hdf5.h"
+#include "h5_stats.h"
+#include "h5_chunk_tuner.h"
+#include "h5_block_cache.h"
+#include "mapped_region.h"
 #include <map>
 #include <string>
 #include <chrono>
@@ -11,28 +15,318 @@
 #include <random>
 #include <filesystem>
 #include <queue>
+#include <deque>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+#include <limits>
+#include <array>
+#include <type_traits>
+#include <utility>
+#include <thread>
+#include <condition_variable>
+#include <atomic>
+#include <cmath>
 
 
+// How writeDictionaryOfScalarsToDataset lays out a dictionary
+enum class DictionaryStorage {
+    Datasets, // One scalar dataset per key, named <name>_<key>
+    Table     // One compound (key, value) dataset named <name>, written in a single call
+};
+
+// On-disk element type of a double matrix, converted on every write and read
+enum class StorageType {
+    Float64,
+    Float32,
+    ScaledInt16, // offset + scale * integer, see Quantisation
+    ScaledInt32
+};
+
+inline bool isScaled(StorageType storage) {
+    return storage == StorageType::ScaledInt16 || storage == StorageType::ScaledInt32;
+}
+
+// Scale-offset quantisation of doubles: value = offset + scale * code. The lowest
+// code of the storage type stands for NaN, values outside the range saturate.
+struct Quantisation {
+    double scale = 1.0;
+    double offset = 0.0;
+    int32_t nan_code = std::numeric_limits<int32_t>::min();
+
+    // One path for single values and buffers, so both round alike
+    int32_t encode(double value) const {
+        int32_t code;
+        encode(&value, 1, &code);
+        return code;
+    }
+    double decode(int32_t code) const {
+        return code == nan_code ? std::numeric_limits<double>::quiet_NaN() : offset + scale * code;
+    }
+
+    // Whole buffers, in loops the compiler can vectorise
+    void encode(const double* values, size_t count, int32_t* codes) const;
+    void decode(const int32_t* codes, size_t count, double* values) const;
+};
+
+struct MatrixOptions {
+    bool chunked = false;            // Chunked layout with NaN fill value instead of writing a full NaN buffer
+    std::vector<hsize_t> chunk_dims; // Chunk shape, chosen from the dims when empty
+    int compression_level = 0;       // Shuffle + deflate at this level (1-9), implies chunked
+    AccessPattern access;            // Expected accesses; picks chunk_dims and the chunk cache when those are not given, implies chunked
+    std::vector<int> unlimited_axes; // Axes grown by appendSlab, dims give their initial extent (may be 0), implies chunked
+    StorageType storage = StorageType::Float64; // Reduced precision on disk, double matrices only
+    double scale = 1.0;              // Quantisation step of the scaled integer types
+    double offset = 0.0;             // Value stored as integer 0
+};
+
+class H5FileWriter;
+class H5FileReader;
+
+// Native HDF5 memory type of a matrix element type
+template <typename T> hid_t nativeType();
+template <> inline hid_t nativeType<double>() { return H5T_NATIVE_DOUBLE; }
+template <> inline hid_t nativeType<float>() { return H5T_NATIVE_FLOAT; }
+template <> inline hid_t nativeType<int8_t>() { return H5T_NATIVE_INT8; }
+template <> inline hid_t nativeType<uint8_t>() { return H5T_NATIVE_UINT8; }
+template <> inline hid_t nativeType<int16_t>() { return H5T_NATIVE_INT16; }
+template <> inline hid_t nativeType<uint16_t>() { return H5T_NATIVE_UINT16; }
+template <> inline hid_t nativeType<int32_t>() { return H5T_NATIVE_INT32; }
+template <> inline hid_t nativeType<uint32_t>() { return H5T_NATIVE_UINT32; }
+template <> inline hid_t nativeType<int64_t>() { return H5T_NATIVE_INT64; }
+template <> inline hid_t nativeType<uint64_t>() { return H5T_NATIVE_UINT64; }
+
+// Handle on a matrix of compile-time rank. The file dataspace and a one-element
+// memory space are created once and reused by every point access, so a handle
+// must stay on one thread. Handles from a writer must not outlive it. Handles
+// on unlimited axes see the rows appended through the writer's appendSlab.
+template <size_t Rank, typename T = double>
+class Matrix {
+    static_assert(Rank >= 1 && Rank <= 8, "Matrix rank must be between 1 and 8");
+
+    public:
+
+        using Index = std::array<hsize_t, Rank>;
+
+        Matrix() = default;
+        Matrix(Matrix&& other) noexcept { *this = std::move(other); }
+        Matrix& operator=(Matrix&& other) noexcept;
+        Matrix(const Matrix&) = delete;
+        Matrix& operator=(const Matrix&) = delete;
+        ~Matrix() { release(); }
+
+        template <typename... I>
+        void write(T value, I... index) {
+            static_assert(sizeof...(I) == Rank, "One index per dimension");
+            write(value, Index{static_cast<hsize_t>(index)...});
+        }
+        void write(T value, const Index& index);
+
+        template <typename... I>
+        T read(I... index) const {
+            static_assert(sizeof...(I) == Rank, "One index per dimension");
+            return read(Index{static_cast<hsize_t>(index)...});
+        }
+        T read(const Index& index) const;
+
+        const Index& dims() const { if (growable) refresh(); return extents; }
+        hid_t id() const { return dataset; }
+        bool valid() const { return dataset >= 0; }
+
+    protected:
+        friend class H5FileWriter;
+        friend class H5FileReader;
+
+        Matrix(hid_t dataset, const Index& extents, H5FileWriter* writer, std::shared_ptr<const void> keep_alive, const double* mapped);
+
+        // Negative indices wrapped to huge values on conversion, so one comparison per axis covers them
+        template <size_t... D>
+        bool inBounds(const Index& index, std::index_sequence<D...>) const { return ((index[D] < extents[D]) && ...); }
+        void checkBounds(const Index& index) const;
+        void select(const Index& index) const;
+        void refresh() const;
+        void release();
+
+        hid_t dataset = -1;
+        mutable hid_t filespace = -1;
+        hid_t memspace = -1;
+        // Handles on unlimited axes follow appendSlab and trims through the writer's matrix info
+        bool growable = false;
+        mutable Index extents = {};
+        mutable Index strides = {};      // Row-major element strides, for mapped reads
+        mutable Index capacity = {};     // File extent behind filespace
+        H5FileWriter* writer = nullptr;  // Set for handles from generateMatrix
+        std::shared_ptr<const void> keep_alive; // Reader dataset entry for handles from openMatrix
+        const double* mapped = nullptr;
+        const Quantisation* quantisation = nullptr; // Scaled integer storage, owned by the writer or the reader entry
+};
+
+// Rows [row_offset, row_offset + rows) of a virtual matrix, taken from a dataset in another file
+struct VirtualSource {
+    std::string file;    // Relative names resolve against the directory of the virtual file
+    std::string dataset;
+    hsize_t row_offset = 0;
+    hsize_t rows = 0;
+};
+
+// Where H5FileWriter builds its file
+enum class WriterStorage {
+    Disk,           // Created on disk up front
+    Memory,         // Held in RAM only, see H5FileWriter::fileImage
+    MemoryPersisted // Held in RAM and written to disk in one go when the writer closes
+};
+
 class H5FileWriter {
 
     public:
 
-        H5FileWriter(std::string& directory, std::string& file_prefix);
+        H5FileWriter(std::string& directory, std::string& file_prefix, WriterStorage storage = WriterStorage::Disk);
         ~H5FileWriter();
 
         void writeScalarToDataset(const std::string& name, double value);
-        void writeDictionaryOfScalarsToDataset(const std::string& name, const std::map<std::string, double>& values);
+        void writeDictionaryOfScalarsToDataset(const std::string& name, const std::map<std::string, double>& values, DictionaryStorage storage = DictionaryStorage::Datasets);
         void writeMatrixAxisToDataset(const std::string& name, const std::vector<double>& axis);
 
-        hid_t generate4DMatrix(const std::string& name, size_t N, size_t M, size_t O, size_t P);
+        hid_t generate4DMatrix(const std::string& name, size_t N, size_t M, size_t O, size_t P, const MatrixOptions& options = MatrixOptions());
         void writeTo4DMatrix(hid_t dataset, double value, int i, int j, int k, int l);
 
-        hid_t generate5DMatrix(const std::string& name, size_t N, size_t M, size_t O, size_t P, size_t Q);
+        hid_t generate5DMatrix(const std::string& name, size_t N, size_t M, size_t O, size_t P, size_t Q, const MatrixOptions& options = MatrixOptions());
         void writeTo5DMatrix(hid_t dataset, double value, int i, int j, int k, int l, int m);
 
+        // Matrix of any rank from 1 to 8 and element type T, see Matrix
+        template <size_t Rank, typename T = double>
+        Matrix<Rank, T> generateMatrix(const std::string& name, const std::array<hsize_t, Rank>& dims, const MatrixOptions& options = MatrixOptions());
+
+        // Scattered point writes in one call; coords holds rank indices per value
+        void writePointsTo4DMatrix(hid_t dataset, const std::vector<double>& values, const std::vector<hsize_t>& coords);
+        void writePointsTo5DMatrix(hid_t dataset, const std::vector<double>& values, const std::vector<hsize_t>& coords);
+
+        // Append whole slices along an unlimited axis, values in row-major order. Storage grows
+        // geometrically and every flush trims it back to the extent appended so far.
+        void appendSlab(hid_t dataset, int axis, const std::vector<double>& values);
+        void appendSlab(hid_t dataset, int axis, const double* values, size_t count);
+
+        // Matrix stitched together along axis 0 from datasets in other files, NaN where no source maps
+        hid_t generateVirtualMatrix(const std::string& name, const std::vector<hsize_t>& dims, const std::vector<VirtualSource>& sources);
+
+        // Write the block at offset with the given extents on a background thread. The owning
+        // overload hands the buffer back through the future for reuse; the pinned overload reads
+        // values until its future is ready. Blocks are written in submission order and must not
+        // overlap staged point writes before drain(). Runs inline if HDF5 is not thread safe.
+        std::future<std::vector<double>> writeBlockAsync(hid_t dataset, const std::vector<hsize_t>& offset, const std::vector<hsize_t>& extents, std::vector<double> values);
+        std::future<void> writeBlockAsync(hid_t dataset, const std::vector<hsize_t>& offset, const std::vector<hsize_t>& extents, const double* values);
+
+        // Submissions block while more than max_bytes of blocks are in flight
+        void setMaxInFlightBytes(size_t max_bytes);
+
+        // Wait until every submitted block is written
+        void drain();
+
+        // Stage matrix point writes in memory and write them out as whole tiles
+        void enableBufferedWrites(size_t tile_elements = 65536, size_t max_tiles_per_dataset = 4);
+        void flush(); // Also drains block writes
+
+        // Single-writer/multiple-reader mode for readers opened with ReaderMode::Live.
+        // Create every dataset first. Afterwards the first write after each flush_interval
+        // writes out staged data and file metadata, so live readers lag by about that much.
+        void startLiveProgress(std::chrono::milliseconds flush_interval = std::chrono::seconds(1));
+        void flushLiveProgress(); // Flush now, e.g. before the writer goes idle
+        bool liveProgress() const { return live_dataset >= 0; }
+
+        const std::string& getFilePath() const { return file_path; }
+
+        // Copy of the complete in-memory file after a flush, for H5FileReader; the writer stays usable
+        std::vector<unsigned char> fileImage();
+
+        // Process-wide counters, empty unless built with HDF5MT_ENABLE_STATS
+        static H5StatsSnapshot stats() { return H5Stats::snapshot(); }
+
     protected:
+        template <size_t Rank, typename T> friend class Matrix;
+        friend class H5WriterFactory;
+
+        // fcpl, fapl, dcpl, dapl, dxpl and lcpl, in that order
+        using PropertyLists = std::array<hid_t, 6>;
+        static PropertyLists createPropertyLists(WriterStorage storage);
+
+        // Takes over a file created by H5WriterFactory and shares its property lists
+        H5FileWriter(hid_t file, const std::string& file_path, WriterStorage storage, const PropertyLists& property_lists);
+
+        struct StagingTile {
+            std::vector<hsize_t> offset; // Tile origin in the dataset
+            std::vector<hsize_t> count;  // Tile extent, clipped to the dataset edge
+            std::vector<double> values;
+            std::vector<bool> written;
+            size_t written_count = 0;
+            uint64_t last_used = 0;
+        };
+
+        struct MatrixInfo {
+            std::vector<hsize_t> dims;
+            std::vector<hsize_t> chunk; // Empty for contiguous matrices
+            std::vector<hsize_t> tile;  // Staging tile shape
+            std::map<hsize_t, StagingTile> tiles;
+            int compression_level = 0;
+            StorageType storage = StorageType::Float64;
+            Quantisation quantisation;
+            std::vector<bool> unlimited;   // Axes appendSlab may grow
+            std::vector<hsize_t> capacity; // Allocated extent, ahead of dims while appending
+        };
+
+        struct PendingChunk {
+            hid_t dataset;
+            std::vector<hsize_t> offset;
+            std::future<std::vector<unsigned char>> bytes; // Shuffled and deflated on the thread pool
+        };
+
+        static constexpr size_t default_chunk_elements = 65536; // 512 KiB of doubles, fits the default chunk cache
+
+        struct BlockWrite {
+            hid_t dataset;
+            std::vector<hsize_t> offset;
+            std::vector<hsize_t> extents;
+            std::vector<double> owned;     // Empty for pinned blocks
+            const double* values;
+            size_t bytes;
+            StorageType storage;        // Copied from the matrix, the map is not safe to read from the block thread
+            Quantisation quantisation;
+            bool returns_buffer;
+            std::promise<std::vector<double>> buffer_returned;
+            std::promise<void> written;
+        };
+
+        hid_t createMatrix(const std::string& name, const std::vector<hsize_t>& dims, const MatrixOptions& options, hid_t type = H5T_NATIVE_DOUBLE);
+        void registerMatrix(hid_t dataset, const std::vector<hsize_t>& dims, const std::vector<hsize_t>& chunk, int compression_level);
+        // Values converted for the matrix storage type, valid until the next conversion on this thread
+        const void* encode(hid_t dataset, const double* values, size_t count, hid_t& memory_type) const;
+        std::vector<hsize_t> stagingTileShape(const MatrixInfo& info) const;
+        void writePoint(hid_t dataset, double value, const hsize_t* offset, int rank);
+        void writeDictionaryTable(const std::string& name, const std::map<std::string, double>& values);
+        void writePoints(hid_t dataset, const std::vector<double>& values, const std::vector<hsize_t>& coords, int rank);
+        void stagePoint(MatrixInfo& info, hid_t dataset, double value, const hsize_t* offset);
+        bool stagedPoint(hid_t dataset, const hsize_t* offset, double& value) const;
+        void flushTile(hid_t dataset, const MatrixInfo& info, const StagingTile& tile);
+        void compressChunk(hid_t dataset, const MatrixInfo& info, const StagingTile& tile);
+        void writeCompressedChunks(bool wait_for_all);
+        void flushMatrix(hid_t dataset, MatrixInfo& info);
+        void trimMatrices();
+        std::unique_ptr<BlockWrite> prepareBlock(hid_t dataset, const std::vector<hsize_t>& offset, const std::vector<hsize_t>& extents, size_t elements);
+        void submitBlock(std::unique_ptr<BlockWrite> block);
+        void writeBlock(BlockWrite& block);
+        void runBlockWrites();
+
+        // Cheap per-write check, the timer thread only raises a flag
+        void liveTick() {
+            if (live_due.load(std::memory_order_relaxed)) flushLiveProgress();
+        }
+        void requireNotLive(const std::string& name) const;
+
         hid_t file;
         std::string file_path;
+        WriterStorage storage;
 
         hid_t fcpl; // File creation property list
         hid_t fapl; // File access property list
@@ -42,24 +336,402 @@ class H5FileWriter {
         hid_t lcpl; // Link creation property list
 
         std::vector<hid_t> open_datasets;
-        
+        std::map<hid_t, MatrixInfo> matrices;
+        std::deque<PendingChunk> pending_chunks;
+
+        bool buffered_writes = false;
+        size_t tile_elements = 0;
+        size_t max_tiles_per_dataset = 0;
+        uint64_t tile_clock = 0;
+
+        // Background block writes, the thread starts with the first block
+        std::thread block_thread;
+        std::mutex block_mutex;
+        std::condition_variable block_submitted;
+        std::condition_variable block_finished;
+        std::deque<std::unique_ptr<BlockWrite>> block_queue;
+        size_t in_flight_bytes = 0;
+        size_t max_in_flight_bytes = 64 << 20;
+        bool block_stopping = false;
+
+        // Live progress: a timer thread marks when the next write should flush
+        hid_t live_dataset = -1; // Flush generation and time, polled by live readers
+        uint64_t live_generation = 0;
+        std::atomic<bool> live_due{false};
+        std::thread live_thread;
+        std::mutex live_mutex;
+        std::condition_variable live_stop;
+        bool live_stopping = false;
+
+};
+
+struct MatrixStatistics {
+    double min = std::numeric_limits<double>::quiet_NaN();
+    double max = std::numeric_limits<double>::quiet_NaN();
+    std::vector<hsize_t> argmin; // Coordinates of the first minimum
+    std::vector<hsize_t> argmax; // Coordinates of the first maximum
+    double sum = 0.0;
+    double mean = std::numeric_limits<double>::quiet_NaN();
+    uint64_t finite_count = 0; // Values taking part in sum/mean; min/max also take infinities
+    uint64_t nan_count = 0;
+};
+
+// Non-owning strided view over a slice read into contiguous memory
+struct SliceView {
+    static constexpr int max_rank = 8;
+
+    const double* data = nullptr;
+    int rank = 0;
+    hsize_t extents[max_rank] = {};
+    hsize_t strides[max_rank] = {}; // In elements
+
+    size_t size() const {
+        size_t elements = 1;
+        for (int d = 0; d < rank; ++d) elements *= extents[d];
+        return elements;
+    }
+    const double& operator()(hsize_t i, hsize_t j) const { return data[i * strides[0] + j * strides[1]]; }
+    const double& operator()(hsize_t i, hsize_t j, hsize_t k) const { return data[i * strides[0] + j * strides[1] + k * strides[2]]; }
+};
+
+// How H5FileReader opens a file
+enum class ReaderMode {
+    Default,
+    Live     // Alongside an H5FileWriter in live progress mode, see H5FileReader::refresh
+};
+
+// Writer flush a live reader has caught up with
+struct LiveProgress {
+    uint64_t generation = 0; // Counts writer flushes, 0 before the first
+    std::chrono::system_clock::time_point flushed;
 };
 
 class H5FileReader {
     public:
-        H5FileReader(const std::string& file_path);
+        H5FileReader(const std::string& file_path, ReaderMode mode = ReaderMode::Default);
+
+        // Read a file image from H5FileWriter::fileImage without touching the filesystem;
+        // name only shows up in error messages
+        explicit H5FileReader(std::vector<unsigned char> image, const std::string& name = "file image");
         ~H5FileReader();
 
         std::vector<double> readMatrixAxisFromDataset(const std::string& name);
         double readScalarFromDataset(const std::string& name);
+
+        // Whole dictionary in one read, from a table or from per-key datasets.
+        // Dictionaries are cached, so key lookups after the first are served from memory.
+        std::map<std::string, double> readDictionaryFromDataset(const std::string& name);
+        double readScalarFromDictionary(const std::string& name, const std::string& key);
         std::vector<std::vector<double>> read2DSliceFromMatrix(const std::string& name, int i, int j);
         double readPointFromMatrix(const std::string& name, int i, int j, int k, int l);
         double readPointFromVector(const std::string& name, int i);
+
+        // Handle for repeated point reads, see Matrix
+        template <size_t Rank, typename T = double>
+        Matrix<Rank, T> openMatrix(const std::string& name);
+
+        // Slice along the given free axes (in view order) at index on every other axis.
+        // A caller kept buffer only grows, so repeated reads allocate nothing once it holds
+        // the largest slice; the view is valid until the buffer next changes.
+        SliceView readSlice(const std::string& name, const std::vector<int>& axes, const std::vector<hsize_t>& index, double* out);
+        SliceView readSlice(const std::string& name, const std::vector<int>& axes, const std::vector<hsize_t>& index, std::vector<double>& buffer);
+
+        // Scattered point reads in one call; coords holds rank indices per point
+        std::vector<double> readPointsFromMatrix(const std::string& name, const std::vector<hsize_t>& coords);
+        void readPointsFromMatrix(const std::string& name, const hsize_t* coords, size_t count, double* out);
+
         double getMinimumFromMatrix(const std::string& name);
 
+        // Whole dataset in row-major order, out holds the product of getMatrixDims
+        std::vector<hsize_t> getMatrixDims(const std::string& name);
+        void readMatrix(const std::string& name, double* out);
+
+        // One streaming pass over a dataset of any rank, block_elements bounds the memory per buffer
+        MatrixStatistics reduceMatrix(const std::string& name, size_t block_elements = 1 << 20);
+
+        // Bound the number of datasets kept open, 0 keeps every dataset open
+        void setDatasetCacheLimit(size_t max_datasets);
+
+        // Serve contiguous native-double datasets from a memory mapping (on by default)
+        void setMemoryMapping(bool enabled);
+
+        // Share decoded blocks of datasets that are not memory mapped through cache, e.g.
+        // &H5BlockCache::shared(); nullptr (the default) reads straight from the file. Whole
+        // matrix reductions always bypass the cache.
+        void setBlockCache(H5BlockCache* cache);
+
+        // On a miss, also load up to blocks following blocks along the axis being stepped
+        void setReadahead(size_t blocks);
+
+        // Live mode only: pick up everything the writer has flushed without reopening the file.
+        // Datasets and dictionaries are reloaded on next use; handles from openMatrix see new
+        // values but keep their shape. Live readers never use the block cache.
+        LiveProgress refresh();
+
+        // Refresh as soon as the writer flushes again, false if it did not within timeout
+        bool poll(std::chrono::milliseconds timeout);
+
+        // Process-wide counters, empty unless built with HDF5MT_ENABLE_STATS
+        static H5StatsSnapshot stats() { return H5Stats::snapshot(); }
+
     protected:
+        struct DatasetEntry {
+            hid_t dataset = -1;
+            hid_t dataspace = -1; // Template for selections, copied per read
+            std::vector<hsize_t> dims;
+            std::vector<hsize_t> chunk; // Empty unless the layout is chunked
+            std::vector<hsize_t> cache_block; // Block shape used in the block cache
+            std::unique_ptr<MappedRegion> mapping;
+            std::shared_ptr<const std::vector<unsigned char>> image; // Backs mapped for file images
+            StorageType storage = StorageType::Float64;
+            Quantisation quantisation;
+            const double* mapped = nullptr; // Raw dataset values when memory mapped
+
+            DatasetEntry() = default;
+            DatasetEntry(const DatasetEntry&) = delete;
+            DatasetEntry& operator=(const DatasetEntry&) = delete;
+            ~DatasetEntry();
+        };
+
+        struct CacheSlot {
+            std::shared_ptr<DatasetEntry> entry;
+            std::list<std::string>::iterator recency;
+        };
+
+        std::shared_ptr<DatasetEntry> openDataset(const std::string& name);
+        hid_t chunkCacheAccessList(const std::string& name);
+        std::shared_ptr<const std::map<std::string, double>> loadDictionary(const std::string& name);
+        void mapDataset(DatasetEntry& entry);
+        hid_t copyDataspace(const DatasetEntry& entry, const std::string& name);
+        std::vector<hsize_t> readBlockShape(const DatasetEntry& entry, size_t max_elements) const;
+        // H5Dread of count doubles, widened from the stored type
+        herr_t readValues(const DatasetEntry& entry, hid_t memspace, hid_t dataspace, size_t count, double* out);
+        void readBlock(const DatasetEntry& entry, const std::string& name, const hsize_t* offset, const hsize_t* count, double* out);
+        void readCachedBlock(const DatasetEntry& entry, const std::string& name, const hsize_t* offset, const hsize_t* count, double* out, int readahead_axis);
+        H5BlockCache::Block fetchBlock(const DatasetEntry& entry, H5BlockCache::Key& key, const std::vector<hsize_t>& position, int readahead_axis);
+        LiveProgress readLiveProgress();
+
         hid_t file;
         std::string file_path;
+        std::shared_ptr<const std::vector<unsigned char>> image; // Set when reading a file image
+
+        // Open datasets by name, most recently used first in dataset_recency
+        std::mutex dataset_mutex;
+        std::unordered_map<std::string, CacheSlot> dataset_cache;
+        std::list<std::string> dataset_recency;
+        size_t dataset_cache_limit = 0;
+        bool memory_mapping = true;
+
+        static constexpr size_t cache_block_elements = 16384; // 128 KiB blocks for contiguous datasets
+        std::atomic<H5BlockCache*> block_cache{nullptr};
+        std::atomic<size_t> readahead_blocks{0};
+        std::string file_identity; // Block cache key, path plus modification time
+
+        bool live = false;
+        std::atomic<uint64_t> live_generation{0};
+        std::vector<std::weak_ptr<DatasetEntry>> live_entries; // Every entry opened, for refresh
+
+        std::mutex dictionary_mutex;
+        std::unordered_map<std::string, std::shared_ptr<const std::map<std::string, double>>> dictionary_cache;
 };
 
+template <size_t Rank, typename T>
+Matrix<Rank, T>::Matrix(hid_t dataset, const Index& extents, H5FileWriter* writer, std::shared_ptr<const void> keep_alive, const double* mapped)
+    : dataset(dataset), extents(extents), capacity(extents), writer(writer), keep_alive(std::move(keep_alive)) {
+    if constexpr (std::is_same<T, double>::value) {
+        this->mapped = mapped;
+    }
+    hsize_t stride = 1;
+    for (size_t d = Rank; d-- > 0;) {
+        strides[d] = stride;
+        stride *= extents[d];
+    }
+
+    const hsize_t one = 1;
+    filespace = H5Dget_space(dataset);
+    memspace = H5Screate_simple(1, &one, nullptr);
+    if (filespace < 0 || memspace < 0) {
+        release();
+        throw std::runtime_error("Failed to create dataspaces for matrix handle");
+    }
+}
+
+template <size_t Rank, typename T>
+Matrix<Rank, T>& Matrix<Rank, T>::operator=(Matrix&& other) noexcept {
+    if (this != &other) {
+        release();
+        dataset = other.dataset;
+        filespace = other.filespace;
+        memspace = other.memspace;
+        growable = other.growable;
+        extents = other.extents;
+        strides = other.strides;
+        capacity = other.capacity;
+        writer = other.writer;
+        keep_alive = std::move(other.keep_alive);
+        mapped = other.mapped;
+        quantisation = other.quantisation;
+        other.dataset = other.filespace = other.memspace = -1;
+        other.writer = nullptr;
+        other.mapped = nullptr;
+        other.quantisation = nullptr;
+    }
+    return *this;
+}
+
+template <size_t Rank, typename T>
+void Matrix<Rank, T>::release() {
+    // The dataset itself belongs to the writer or reader
+    if (filespace >= 0) H5Sclose(filespace);
+    if (memspace >= 0) H5Sclose(memspace);
+    filespace = memspace = -1;
+    dataset = -1;
+}
+
+template <size_t Rank, typename T>
+void Matrix<Rank, T>::checkBounds(const Index& index) const {
+    if (dataset < 0) {
+        throw std::runtime_error("Matrix handle is empty");
+    }
+    if (growable) refresh();
+    if (!inBounds(index, std::make_index_sequence<Rank>())) {
+        throw std::out_of_range("Matrix indices are out of bounds");
+    }
+}
+
+template <size_t Rank, typename T>
+void Matrix<Rank, T>::refresh() const {
+    auto it = writer->matrices.find(dataset);
+    if (it == writer->matrices.end()) return;
+    const H5FileWriter::MatrixInfo& info = it->second;
+
+    // The file extent only changes when appendSlab grows or a flush trims it
+    if (!std::equal(capacity.begin(), capacity.end(), info.capacity.begin())) {
+        hid_t space = H5Dget_space(dataset);
+        if (space < 0) {
+            throw std::runtime_error("Failed to refresh filespace for matrix handle");
+        }
+        H5Sclose(filespace);
+        filespace = space;
+        std::copy(info.capacity.begin(), info.capacity.end(), capacity.begin());
+    }
+    std::copy(info.dims.begin(), info.dims.end(), extents.begin());
+    hsize_t stride = 1;
+    for (size_t d = Rank; d-- > 0;) {
+        strides[d] = stride;
+        stride *= extents[d];
+    }
+}
+
+template <size_t Rank, typename T>
+void Matrix<Rank, T>::select(const Index& index) const {
+    static const Index ones = [] { Index count; count.fill(1); return count; }();
+    if (H5Sselect_hyperslab(filespace, H5S_SELECT_SET, index.data(), nullptr, ones.data(), nullptr) < 0) {
+        throw std::runtime_error("Failed to select hyperslab for matrix point");
+    }
+}
+
+template <size_t Rank, typename T>
+void Matrix<Rank, T>::write(T value, const Index& index) {
+    H5_STATS_OPERATION(H5Operation::Write, sizeof(T));
+    checkBounds(index);
+    if (writer) writer->liveTick();
+
+    if constexpr (std::is_same<T, double>::value) {
+        if (writer && writer->buffered_writes) {
+            auto it = writer->matrices.find(dataset);
+            if (it != writer->matrices.end()) {
+                writer->stagePoint(it->second, dataset, value, index.data());
+                return;
+            }
+        }
+    }
+
+    select(index);
+    hid_t transfer = writer ? writer->dxpl : H5P_DEFAULT;
+    if constexpr (std::is_same<T, double>::value) {
+        if (quantisation) {
+            int32_t code = quantisation->encode(value);
+            if (H5_STATS_LIBRARY(H5Dwrite(dataset, H5T_NATIVE_INT32, memspace, filespace, transfer, &code)) < 0) {
+                throw std::runtime_error("Failed to write value to dataset.");
+            }
+            return;
+        }
+    }
+    if (H5_STATS_LIBRARY(H5Dwrite(dataset, nativeType<T>(), memspace, filespace, transfer, &value)) < 0) {
+        throw std::runtime_error("Failed to write value to dataset.");
+    }
+}
+
+template <size_t Rank, typename T>
+T Matrix<Rank, T>::read(const Index& index) const {
+    H5_STATS_OPERATION(H5Operation::Read, sizeof(T));
+    checkBounds(index);
+
+    if constexpr (std::is_same<T, double>::value) {
+        if (mapped) {
+            hsize_t position = 0;
+            for (size_t d = 0; d < Rank; ++d) position += index[d] * strides[d];
+            return mapped[position];
+        }
+        // Values still staged in the writer have not reached the file yet
+        double staged;
+        if (writer && writer->stagedPoint(dataset, index.data(), staged)) {
+            return staged;
+        }
+    }
+    if (writer && !writer->pending_chunks.empty()) {
+        writer->writeCompressedChunks(true);
+    }
+
+    select(index);
+    T value;
+    hid_t transfer = writer ? writer->dxpl : H5P_DEFAULT;
+    if constexpr (std::is_same<T, double>::value) {
+        if (quantisation) {
+            int32_t code;
+            if (H5_STATS_LIBRARY(H5Dread(dataset, H5T_NATIVE_INT32, memspace, filespace, transfer, &code)) < 0) {
+                throw std::runtime_error("Failed to read value from dataset.");
+            }
+            return quantisation->decode(code);
+        }
+    }
+    if (H5_STATS_LIBRARY(H5Dread(dataset, nativeType<T>(), memspace, filespace, transfer, &value)) < 0) {
+        throw std::runtime_error("Failed to read value from dataset.");
+    }
+    return value;
+}
+
+template <size_t Rank, typename T>
+Matrix<Rank, T> H5FileWriter::generateMatrix(const std::string& name, const std::array<hsize_t, Rank>& dims, const MatrixOptions& options) {
+    hid_t dataset = createMatrix(name, std::vector<hsize_t>(dims.begin(), dims.end()), options, nativeType<T>());
+    Matrix<Rank, T> matrix(dataset, dims, this, nullptr, nullptr);
+    matrix.growable = !options.unlimited_axes.empty();
+    auto it = matrices.find(dataset);
+    if (it != matrices.end() && isScaled(it->second.storage)) {
+        matrix.quantisation = &it->second.quantisation;
+    }
+    return matrix;
+}
+
+template <size_t Rank, typename T>
+Matrix<Rank, T> H5FileReader::openMatrix(const std::string& name) {
+    auto entry = openDataset(name);
+    if (entry->dims.size() != Rank) {
+        throw std::invalid_argument("Dataset is not a " + std::to_string(Rank) + "D matrix: " + name);
+    }
+    typename Matrix<Rank, T>::Index dims;
+    std::copy(entry->dims.begin(), entry->dims.end(), dims.begin());
+    const double* mapped = entry->mapped;
+    hid_t dataset = entry->dataset;
+    const Quantisation* quantisation = isScaled(entry->storage) ? &entry->quantisation : nullptr;
+    Matrix<Rank, T> matrix(dataset, dims, nullptr, std::move(entry), mapped);
+    if constexpr (std::is_same<T, double>::value) {
+        matrix.quantisation = quantisation;
+    } else if (quantisation) {
+        throw std::invalid_argument("Scaled integer matrices can only be opened as double: " + name);
+    }
+    return matrix;
+}
+
 #endif // H5_H
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "h5_block_cache.h"
+
+#include <algorithm>
+#include <functional>
+
+H5BlockCache::H5BlockCache(size_t capacity_bytes, size_t shards) {
+    shards = std::max<size_t>(shards, 1);
+    for (size_t n = 0; n < shards; ++n) {
+        this->shards.push_back(std::make_unique<Shard>());
+    }
+    shard_capacity.store(capacity_bytes / shards, std::memory_order_relaxed);
+}
+
+H5BlockCache& H5BlockCache::shared() {
+    static H5BlockCache cache;
+    return cache;
+}
+
+size_t H5BlockCache::KeyHash::operator()(const Key& key) const {
+    size_t hash = std::hash<std::string>()(key.file);
+    hash ^= std::hash<std::string>()(key.dataset) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<uint64_t>()(key.block) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+H5BlockCache::Shard& H5BlockCache::shardFor(const Key& key) {
+    return *shards[KeyHash()(key) % shards.size()];
+}
+
+const H5BlockCache::Shard& H5BlockCache::shardFor(const Key& key) const {
+    return *shards[KeyHash()(key) % shards.size()];
+}
+
+H5BlockCache::Block H5BlockCache::find(const Key& key) {
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(key);
+    if (it == shard.entries.end()) {
+        shard.stats.misses++;
+        return nullptr;
+    }
+    shard.stats.hits++;
+    shard.recency.splice(shard.recency.begin(), shard.recency, it->second.recency);
+    return it->second.block;
+}
+
+bool H5BlockCache::contains(const Key& key) const {
+    const Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.entries.count(key) > 0;
+}
+
+void H5BlockCache::insert(const Key& key, Block block, bool readahead) {
+    const size_t bytes = block->size() * sizeof(double);
+    const size_t capacity = shard_capacity.load(std::memory_order_relaxed);
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (bytes > capacity) return;
+
+    auto it = shard.entries.find(key);
+    if (it != shard.entries.end()) {
+        // Another reader loaded it first; keep the newer copy
+        shard.bytes -= it->second.block->size() * sizeof(double);
+        it->second.block = std::move(block);
+        shard.recency.splice(shard.recency.begin(), shard.recency, it->second.recency);
+    } else {
+        shard.recency.push_front(key);
+        shard.entries.emplace(key, Entry{std::move(block), shard.recency.begin()});
+    }
+    shard.bytes += bytes;
+    if (readahead) shard.stats.readahead++;
+    evict(shard, capacity);
+}
+
+void H5BlockCache::evict(Shard& shard, size_t capacity) {
+    while (shard.bytes > capacity && !shard.recency.empty()) {
+        auto it = shard.entries.find(shard.recency.back());
+        shard.bytes -= it->second.block->size() * sizeof(double);
+        shard.entries.erase(it);
+        shard.recency.pop_back();
+        shard.stats.evictions++;
+    }
+}
+
+void H5BlockCache::setCapacity(size_t capacity_bytes) {
+    const size_t capacity = capacity_bytes / shards.size();
+    shard_capacity.store(capacity, std::memory_order_relaxed);
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        evict(*shard, capacity);
+    }
+}
+
+void H5BlockCache::clear() {
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->entries.clear();
+        shard->recency.clear();
+        shard->bytes = 0;
+    }
+}
+
+H5BlockCache::Stats H5BlockCache::stats() const {
+    Stats total;
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        total.hits += shard->stats.hits;
+        total.misses += shard->stats.misses;
+        total.readahead += shard->stats.readahead;
+        total.evictions += shard->stats.evictions;
+        total.blocks += shard->entries.size();
+        total.bytes += shard->bytes;
+    }
+    return total;
+}
+
+void H5BlockCache::resetStats() {
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->stats = Stats();
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef H5_BLOCK_CACHE_H
+#define H5_BLOCK_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+// Process-wide LRU cache of decoded matrix blocks, keyed by (file, dataset,
+// block index) and shared by every H5FileReader that opts in. Keys are spread
+// over independently locked shards so concurrent readers rarely contend.
+class H5BlockCache {
+
+    public:
+
+        using Block = std::shared_ptr<const std::vector<double>>;
+
+        struct Key {
+            std::string file;    // Path and modification time, so rewritten files miss
+            std::string dataset;
+            uint64_t block = 0;  // Linear index in the dataset's block grid
+
+            bool operator==(const Key& other) const { return block == other.block && dataset == other.dataset && file == other.file; }
+        };
+
+        struct Stats {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            uint64_t readahead = 0; // Blocks inserted ahead of being asked for
+            uint64_t evictions = 0;
+            size_t blocks = 0;
+            size_t bytes = 0;
+
+            double hitRate() const { return hits + misses == 0 ? 0.0 : static_cast<double>(hits) / (hits + misses); }
+        };
+
+        explicit H5BlockCache(size_t capacity_bytes = 256 << 20, size_t shards = 16);
+
+        static H5BlockCache& shared();
+
+        // Counts a hit or a miss
+        Block find(const Key& key);
+        bool contains(const Key& key) const;
+
+        // Blocks larger than a shard's share of the capacity are not kept
+        void insert(const Key& key, Block block, bool readahead = false);
+
+        void setCapacity(size_t capacity_bytes);
+        void clear();
+
+        Stats stats() const;
+        void resetStats();
+
+    protected:
+        struct KeyHash {
+            size_t operator()(const Key& key) const;
+        };
+
+        struct Entry {
+            Block block;
+            std::list<Key>::iterator recency;
+        };
+
+        struct Shard {
+            mutable std::mutex mutex;
+            std::list<Key> recency; // Most recently used first
+            std::unordered_map<Key, Entry, KeyHash> entries;
+            size_t bytes = 0;
+            Stats stats;
+        };
+
+        Shard& shardFor(const Key& key);
+        const Shard& shardFor(const Key& key) const;
+        void evict(Shard& shard, size_t capacity);
+
+        std::vector<std::unique_ptr<Shard>> shards;
+        std::atomic<size_t> shard_capacity{0};
+};
+
+#endif // H5_BLOCK_CACHE_H
@@ -0,0 +1,330 @@
+#include "h5_chunk_tuner.h"
+
+#include <algorithm>
+#include <istream>
+#include <list>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+hsize_t ceilDiv(hsize_t a, hsize_t b) {
+    return (a + b - 1) / b;
+}
+
+hsize_t product(const std::vector<hsize_t>& values) {
+    hsize_t result = 1;
+    for (hsize_t value : values) result *= value;
+    return result;
+}
+
+// Chunk visits of a lexicographic point sweep in the given axis order. A suffix
+// of axes that fits in one chunk merges consecutive iterations of its parent.
+double sweepVisits(const std::vector<hsize_t>& dims, const std::vector<hsize_t>& chunk, const std::vector<int>& order) {
+    double visits = 1.0;
+    bool single_chunk = true;
+    for (size_t position = order.size(); position-- > 0;) {
+        const int axis = order[position];
+        const hsize_t grid = ceilDiv(dims[axis], chunk[axis]);
+        visits = single_chunk ? static_cast<double>(grid) : visits * dims[axis];
+        single_chunk = single_chunk && grid == 1;
+    }
+    return visits;
+}
+
+// Chunks revisited before the sweep leaves them: everything inside the slowest
+// axis that steps within a chunk
+double sweepWorkingSet(const std::vector<hsize_t>& dims, const std::vector<hsize_t>& chunk, const std::vector<int>& order) {
+    double chunks = 1.0;
+    for (size_t position = order.size(); position-- > 0;) {
+        const int axis = order[position];
+        if (chunk[axis] > 1) {
+            double inner = 1.0;
+            for (size_t after = position + 1; after < order.size(); ++after) {
+                inner *= ceilDiv(dims[order[after]], chunk[order[after]]);
+            }
+            chunks = inner;
+        }
+    }
+    return chunks;
+}
+
+double sliceChunks(const std::vector<hsize_t>& dims, const std::vector<hsize_t>& chunk, const std::vector<int>& axes) {
+    double chunks = 1.0;
+    for (int axis : axes) chunks *= ceilDiv(dims[axis], chunk[axis]);
+    return chunks;
+}
+
+void checkAxes(const std::vector<int>& axes, size_t rank, const std::string& what) {
+    for (int axis : axes) {
+        if (axis < 0 || static_cast<size_t>(axis) >= rank) {
+            throw std::invalid_argument(what + " axis " + std::to_string(axis) + " is out of range");
+        }
+    }
+}
+
+bool isPrime(size_t value) {
+    if (value < 2) return false;
+    for (size_t divisor = 2; divisor * divisor <= value; ++divisor) {
+        if (value % divisor == 0) return false;
+    }
+    return true;
+}
+
+// Least recently used set of chunk indices, counting loads. Chunks larger than
+// the cache bypass it, as in the library, so a capacity of 0 loads every time.
+class ChunkCache {
+    public:
+        explicit ChunkCache(size_t capacity) : capacity(capacity) {}
+
+        void touch(hsize_t chunk) {
+            if (capacity == 0) {
+                loads++;
+                return;
+            }
+            if (!order.empty() && order.front() == chunk) return;
+            auto it = slots.find(chunk);
+            if (it != slots.end()) {
+                order.splice(order.begin(), order, it->second);
+                return;
+            }
+            loads++;
+            order.push_front(chunk);
+            slots[chunk] = order.begin();
+            if (slots.size() > capacity) {
+                slots.erase(order.back());
+                order.pop_back();
+            }
+        }
+
+        size_t loads = 0;
+
+    private:
+        size_t capacity;
+        std::list<hsize_t> order;
+        std::unordered_map<hsize_t, std::list<hsize_t>::iterator> slots;
+};
+
+}
+
+void AccessTrace::recordWrite(const std::vector<hsize_t>& index) {
+    accesses.push_back(Access{{}, index, true});
+}
+
+void AccessTrace::recordRead(const std::vector<hsize_t>& index) {
+    accesses.push_back(Access{{}, index, false});
+}
+
+void AccessTrace::recordSlice(const std::vector<int>& axes, const std::vector<hsize_t>& index) {
+    accesses.push_back(Access{axes, index, false});
+}
+
+AccessTrace AccessTrace::load(std::istream& in) {
+    AccessTrace trace;
+    std::string line;
+    size_t number = 0;
+    while (std::getline(in, line)) {
+        number++;
+        std::istringstream fields(line);
+        std::string kind;
+        if (!(fields >> kind) || kind[0] == '#') continue;
+
+        Access access;
+        if (kind == "s") {
+            std::string axes;
+            fields >> axes;
+            std::istringstream list(axes);
+            for (std::string axis; std::getline(list, axis, ',');) {
+                access.axes.push_back(std::stoi(axis));
+            }
+        } else if (kind != "dims" && kind != "w" && kind != "r") {
+            throw std::invalid_argument("Unknown access '" + kind + "' on trace line " + std::to_string(number));
+        }
+        for (hsize_t value; fields >> value;) {
+            access.index.push_back(value);
+        }
+
+        if (kind == "dims") {
+            trace.dims = access.index;
+            continue;
+        }
+        if (access.index.size() != trace.dims.size()) {
+            throw std::invalid_argument("Access rank does not match dims on trace line " + std::to_string(number));
+        }
+        checkAxes(access.axes, trace.dims.size(), "Slice");
+        for (size_t d = 0; d < trace.dims.size(); ++d) {
+            if (access.index[d] >= trace.dims[d] && std::find(access.axes.begin(), access.axes.end(), static_cast<int>(d)) == access.axes.end()) {
+                throw std::out_of_range("Access lies outside dims on trace line " + std::to_string(number));
+            }
+        }
+        access.write = kind == "w";
+        trace.accesses.push_back(std::move(access));
+    }
+    if (trace.dims.empty()) {
+        throw std::invalid_argument("Trace has no dims line");
+    }
+    return trace;
+}
+
+void AccessTrace::save(std::ostream& out) const {
+    out << "dims";
+    for (hsize_t extent : dims) out << " " << extent;
+    out << "\n";
+    for (const Access& access : accesses) {
+        if (!access.axes.empty()) {
+            out << "s ";
+            for (size_t n = 0; n < access.axes.size(); ++n) out << (n ? "," : "") << access.axes[n];
+        } else {
+            out << (access.write ? "w" : "r");
+        }
+        for (hsize_t value : access.index) out << " " << value;
+        out << "\n";
+    }
+}
+
+double AccessTrace::replay(const std::vector<hsize_t>& chunk, size_t cache_bytes) const {
+    const size_t rank = dims.size();
+    std::vector<hsize_t> grid(rank);
+    for (size_t d = 0; d < rank; ++d) grid[d] = ceilDiv(dims[d], chunk[d]);
+
+    const double chunk_elements = static_cast<double>(product(chunk));
+    ChunkCache cache(cache_bytes / (static_cast<size_t>(chunk_elements) * sizeof(double)));
+
+    std::vector<hsize_t> position(rank);
+    for (const Access& access : accesses) {
+        for (size_t d = 0; d < rank; ++d) position[d] = access.index[d] / chunk[d];
+        if (access.axes.empty()) {
+            hsize_t linear = 0;
+            for (size_t d = 0; d < rank; ++d) linear = linear * grid[d] + position[d];
+            cache.touch(linear);
+            continue;
+        }
+
+        // Every chunk along the free axes, odometer style
+        for (int axis : access.axes) position[axis] = 0;
+        for (;;) {
+            hsize_t linear = 0;
+            for (size_t d = 0; d < rank; ++d) linear = linear * grid[d] + position[d];
+            cache.touch(linear);
+
+            size_t carried = access.axes.size();
+            while (carried-- > 0) {
+                const int axis = access.axes[carried];
+                if (++position[axis] < grid[axis]) break;
+                position[axis] = 0;
+            }
+            if (carried == static_cast<size_t>(-1)) break;
+        }
+    }
+    return cache.loads * (chunk_elements + ChunkTuner::chunk_overhead_elements);
+}
+
+std::vector<std::vector<hsize_t>> ChunkTuner::candidates(const std::vector<hsize_t>& dims, size_t max_chunk_elements) {
+    const size_t rank = dims.size();
+    std::vector<std::vector<hsize_t>> extents(rank);
+    for (size_t d = 0; d < rank; ++d) {
+        const hsize_t extent = std::max<hsize_t>(dims[d], 1);
+        for (hsize_t value = 1; value < extent; value <<= 1) extents[d].push_back(value);
+        extents[d].push_back(extent);
+    }
+
+    std::vector<std::vector<hsize_t>> shapes;
+    std::vector<hsize_t> shape(rank);
+    std::vector<size_t> choice(rank, 0);
+    for (;;) {
+        hsize_t elements = 1;
+        for (size_t d = 0; d < rank; ++d) {
+            shape[d] = extents[d][choice[d]];
+            elements *= shape[d];
+        }
+        if (elements <= std::max<size_t>(max_chunk_elements, 1)) {
+            shapes.push_back(shape);
+        }
+
+        size_t d = rank;
+        while (d-- > 0) {
+            if (++choice[d] < extents[d].size()) break;
+            choice[d] = 0;
+        }
+        if (d == static_cast<size_t>(-1)) break;
+    }
+    return shapes;
+}
+
+void ChunkTuner::sizeCache(ChunkLayout& layout, size_t working_set_chunks, size_t max_cache_bytes) {
+    const size_t chunk_bytes = static_cast<size_t>(product(layout.chunk)) * sizeof(double);
+    const size_t chunks = std::max<size_t>(std::min(working_set_chunks, max_cache_bytes / chunk_bytes), 1);
+
+    // The library default of 1 MiB is the floor; slots ~100x the cached chunks, prime, per the HDF5 guidance
+    layout.cache_bytes = std::max<size_t>(chunks * chunk_bytes, 1 << 20);
+    layout.cache_slots = std::max<size_t>(100 * (layout.cache_bytes / chunk_bytes), 521);
+    while (!isPrime(layout.cache_slots)) layout.cache_slots++;
+}
+
+ChunkLayout ChunkTuner::tune(const std::vector<hsize_t>& dims, const AccessPattern& pattern, size_t max_chunk_elements, size_t max_cache_bytes) {
+    const size_t rank = dims.size();
+    if (!pattern.write_order.empty()) {
+        checkAxes(pattern.write_order, rank, "Write order");
+        std::vector<int> sorted(pattern.write_order);
+        std::sort(sorted.begin(), sorted.end());
+        if (sorted.size() != rank || std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+            throw std::invalid_argument("Write order must name every axis once");
+        }
+    }
+    for (const auto& axes : pattern.slice_axes) {
+        checkAxes(axes, rank, "Slice");
+    }
+
+    const double total_elements = static_cast<double>(std::max<hsize_t>(product(dims), 1));
+    ChunkLayout best;
+    double best_cost = 0.0;
+    for (auto& chunk : candidates(dims, max_chunk_elements)) {
+        const double chunk_elements = static_cast<double>(product(chunk));
+        const double chunk_bytes = chunk_elements * sizeof(double);
+        const double per_chunk = chunk_elements + chunk_overhead_elements;
+        double cost = 0.0;
+        double working_set = 1.0;
+
+        // Writes: each chunk once when the sweep working set fits the cache, else once per visit
+        if (!pattern.write_order.empty()) {
+            const double sweep_set = sweepWorkingSet(dims, chunk, pattern.write_order);
+            const double loads = sweep_set * chunk_bytes <= max_cache_bytes
+                ? sliceChunks(dims, chunk, pattern.write_order)
+                : sweepVisits(dims, chunk, pattern.write_order);
+            cost += pattern.write_weight * loads * per_chunk / total_elements;
+            working_set = std::max(working_set, sweep_set);
+        }
+
+        // Slice reads: every chunk along the free axes, per element returned
+        for (const auto& axes : pattern.slice_axes) {
+            double slice_elements = 1.0;
+            for (int axis : axes) slice_elements *= std::max<hsize_t>(dims[axis], 1);
+            const double chunks = sliceChunks(dims, chunk, axes);
+            cost += pattern.read_weight * chunks * per_chunk / slice_elements / pattern.slice_axes.size();
+            working_set = std::max(working_set, chunks);
+        }
+
+        if (best.chunk.empty() || cost < best_cost) {
+            best.chunk = chunk;
+            best.cost = cost;
+            best_cost = cost;
+            sizeCache(best, static_cast<size_t>(working_set), max_cache_bytes);
+        }
+    }
+    return best;
+}
+
+std::vector<ChunkLayout> ChunkTuner::rank(const AccessTrace& trace, size_t cache_bytes, size_t max_chunk_elements) {
+    std::vector<ChunkLayout> layouts;
+    for (auto& chunk : candidates(trace.dims, max_chunk_elements)) {
+        ChunkLayout layout;
+        layout.chunk = chunk;
+        layout.cost = trace.replay(chunk, cache_bytes);
+        sizeCache(layout, cache_bytes / (static_cast<size_t>(product(chunk)) * sizeof(double)), cache_bytes);
+        layouts.push_back(std::move(layout));
+    }
+    std::stable_sort(layouts.begin(), layouts.end(), [](const ChunkLayout& a, const ChunkLayout& b) { return a.cost < b.cost; });
+    return layouts;
+}
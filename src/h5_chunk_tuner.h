@@ -0,0 +1,88 @@
+#ifndef H5_CHUNK_TUNER_H
+#define H5_CHUNK_TUNER_H
+
+#include "hdf5.h"
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+
+// Chunk shape selection from declared or recorded access patterns. Layouts are
+// scored by the chunk bytes moved per useful element, with a fixed per-chunk
+// overhead so that tiny chunks do not win by default.
+
+struct AccessPattern {
+    std::vector<int> write_order;               // Point-write sweep, slowest axis first; empty if not written point by point
+    std::vector<std::vector<int>> slice_axes;   // Free axes of each kind of slice read, e.g. {0, 1} for [:, :, i, j]
+    double write_weight = 1.0;
+    double read_weight = 1.0;
+
+    bool empty() const { return write_order.empty() && slice_axes.empty(); }
+};
+
+struct ChunkLayout {
+    std::vector<hsize_t> chunk;
+    size_t cache_bytes = 0; // Chunk cache (H5Pset_chunk_cache) that holds the working set
+    size_t cache_slots = 0;
+    double cost = 0.0;      // Model cost, only comparable between layouts of one matrix
+};
+
+// Sequence of point and slice accesses against one matrix
+class AccessTrace {
+
+    public:
+
+        struct Access {
+            std::vector<int> axes;        // Free axes of a slice, empty for a point
+            std::vector<hsize_t> index;   // Full coordinates; entries on free axes are ignored
+            bool write = false;
+        };
+
+        explicit AccessTrace(const std::vector<hsize_t>& dims = {}) : dims(dims) {}
+
+        void recordWrite(const std::vector<hsize_t>& index);
+        void recordRead(const std::vector<hsize_t>& index);
+        void recordSlice(const std::vector<int>& axes, const std::vector<hsize_t>& index);
+
+        // Text format, one access per line:
+        //   dims <d0> <d1> ...
+        //   w <i0> <i1> ...              point write
+        //   r <i0> <i1> ...              point read
+        //   s <a0>,<a1> <i0> <i1> ...    slice over axes a0, a1 at the given index
+        static AccessTrace load(std::istream& in);
+        void save(std::ostream& out) const;
+
+        // Chunk bytes loaded through an LRU cache of cache_bytes, plus per-chunk overhead
+        double replay(const std::vector<hsize_t>& chunk, size_t cache_bytes) const;
+
+        std::vector<hsize_t> dims;
+        std::vector<Access> accesses;
+};
+
+class ChunkTuner {
+
+    public:
+
+        static constexpr size_t default_max_chunk_elements = 65536;
+        static constexpr size_t default_max_cache_bytes = 64 << 20;
+
+        // Best layout for the declared pattern under the closed-form model
+        static ChunkLayout tune(const std::vector<hsize_t>& dims, const AccessPattern& pattern,
+                                size_t max_chunk_elements = default_max_chunk_elements,
+                                size_t max_cache_bytes = default_max_cache_bytes);
+
+        // Candidate layouts ordered by replay cost, best first
+        static std::vector<ChunkLayout> rank(const AccessTrace& trace, size_t cache_bytes,
+                                             size_t max_chunk_elements = default_max_chunk_elements);
+
+        // Power-of-two extents (and the full extent) per axis within the element budget
+        static std::vector<std::vector<hsize_t>> candidates(const std::vector<hsize_t>& dims, size_t max_chunk_elements);
+
+        // Chunk cache sized for working_set_chunks chunks of the given shape, within max_cache_bytes
+        static void sizeCache(ChunkLayout& layout, size_t working_set_chunks, size_t max_cache_bytes);
+
+        static constexpr double chunk_overhead_elements = 1024.0; // Lookup and I/O setup per chunk, in element equivalents
+};
+
+#endif // H5_CHUNK_TUNER_H
@@ -0,0 +1,178 @@
+#include "h5_directory_reader.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+
+H5DirectoryReader::H5DirectoryReader(const std::string& directory, const std::string& file_prefix, size_t io_threads)
+    : pool(io_threads) {
+    if (!std::filesystem::is_directory(directory)) {
+        throw std::runtime_error("Directory does not exist: " + directory);
+    }
+
+    const std::string pattern = file_prefix + "___";
+    for (auto& item : std::filesystem::directory_iterator(directory)) {
+        std::string name = item.path().filename().string();
+        if (item.is_regular_file() && name.rfind(pattern, 0) == 0 && item.path().extension() == ".h5") {
+            file_paths.push_back(item.path().string());
+        }
+    }
+    std::sort(file_paths.begin(), file_paths.end());
+
+    hbool_t threadsafe = false;
+    library_threadsafe = H5is_library_threadsafe(&threadsafe) >= 0 && threadsafe;
+}
+
+std::unique_lock<std::mutex> H5DirectoryReader::libraryLock() {
+    if (library_threadsafe) {
+        return std::unique_lock<std::mutex>();
+    }
+    return std::unique_lock<std::mutex>(library_mutex);
+}
+
+template <typename F>
+auto H5DirectoryReader::forEachFile(F fn) -> std::vector<decltype(fn(std::declval<H5FileReader&>(), size_t()))> {
+    using Result = decltype(fn(std::declval<H5FileReader&>(), size_t()));
+
+    std::vector<std::future<Result>> futures;
+    futures.reserve(file_paths.size());
+    for (size_t index = 0; index < file_paths.size(); ++index) {
+        futures.push_back(pool.submit([this, &fn, index]() -> Result {
+            std::unique_ptr<H5FileReader> reader;
+            {
+                auto lock = libraryLock();
+                reader = std::make_unique<H5FileReader>(file_paths[index]);
+            }
+            Result result = fn(*reader, index);
+            auto lock = libraryLock();
+            reader.reset();
+            return result;
+        }));
+    }
+
+    // Wait for every task before rethrowing, fn is borrowed by all of them
+    std::vector<Result> results;
+    results.reserve(futures.size());
+    std::exception_ptr error;
+    for (size_t index = 0; index < futures.size(); ++index) {
+        try {
+            results.push_back(futures[index].get());
+        } catch (const std::exception& e) {
+            if (!error) error = std::make_exception_ptr(std::runtime_error(file_paths[index] + ": " + e.what()));
+            results.emplace_back();
+        }
+    }
+    if (error) std::rethrow_exception(error);
+    return results;
+}
+
+std::vector<double> H5DirectoryReader::readScalars(const std::string& name) {
+    return forEachFile([this, &name](H5FileReader& reader, size_t) {
+        auto lock = libraryLock();
+        return reader.readScalarFromDataset(name);
+    });
+}
+
+std::vector<std::vector<double>> H5DirectoryReader::readAxes(const std::string& name) {
+    return forEachFile([this, &name](H5FileReader& reader, size_t) {
+        auto lock = libraryLock();
+        return reader.readMatrixAxisFromDataset(name);
+    });
+}
+
+std::vector<MatrixStatistics> H5DirectoryReader::reduceMatrices(const std::string& name) {
+    return forEachFile([this, &name](H5FileReader& reader, size_t) {
+        auto lock = libraryLock();
+        return reader.reduceMatrix(name);
+    });
+}
+
+StackedMatrix H5DirectoryReader::stackMatrices(const std::string& name) {
+    StackedMatrix stacked;
+    if (file_paths.empty()) return stacked;
+
+    // The first file fixes the shape, every task then reads straight into its slot
+    std::vector<hsize_t> dims;
+    {
+        auto lock = libraryLock();
+        H5FileReader first(file_paths.front());
+        dims = first.getMatrixDims(name);
+    }
+    size_t elements = 1;
+    for (hsize_t extent : dims) elements *= extent;
+
+    stacked.dims.push_back(file_paths.size());
+    stacked.dims.insert(stacked.dims.end(), dims.begin(), dims.end());
+    stacked.values.resize(file_paths.size() * elements);
+
+    forEachFile([&](H5FileReader& reader, size_t index) {
+        auto lock = libraryLock();
+        if (reader.getMatrixDims(name) != dims) {
+            throw std::invalid_argument("Matrix shape differs from " + file_paths.front() + ": " + name);
+        }
+        reader.readMatrix(name, stacked.values.data() + index * elements);
+        return true;
+    });
+    return stacked;
+}
+
+StackedMatrix H5DirectoryReader::minimumMatrix(const std::string& name) {
+    return combineMatrices(name, true);
+}
+
+StackedMatrix H5DirectoryReader::maximumMatrix(const std::string& name) {
+    return combineMatrices(name, false);
+}
+
+StackedMatrix H5DirectoryReader::combineMatrices(const std::string& name, bool minimum) {
+    StackedMatrix combined;
+    if (file_paths.empty()) return combined;
+    {
+        auto lock = libraryLock();
+        H5FileReader first(file_paths.front());
+        combined.dims = first.getMatrixDims(name);
+    }
+    size_t elements = 1;
+    for (hsize_t extent : combined.dims) elements *= extent;
+
+    // One partial result per worker keeps merges from queueing on a single lock
+    struct Partial {
+        std::mutex mutex;
+        std::vector<double> values;
+    };
+    std::vector<Partial> partials(pool.size());
+
+    forEachFile([&](H5FileReader& reader, size_t index) {
+        std::vector<double> values(elements);
+        {
+            auto lock = libraryLock();
+            if (reader.getMatrixDims(name) != combined.dims) {
+                throw std::invalid_argument("Matrix shape differs from " + file_paths.front() + ": " + name);
+            }
+            reader.readMatrix(name, values.data());
+        }
+
+        Partial& partial = partials[index % partials.size()];
+        std::lock_guard<std::mutex> lock(partial.mutex);
+        if (partial.values.empty()) {
+            partial.values = std::move(values);
+        } else if (minimum) {
+            for (size_t n = 0; n < elements; ++n) partial.values[n] = std::fmin(partial.values[n], values[n]);
+        } else {
+            for (size_t n = 0; n < elements; ++n) partial.values[n] = std::fmax(partial.values[n], values[n]);
+        }
+        return true;
+    });
+
+    for (Partial& partial : partials) {
+        if (partial.values.empty()) continue;
+        if (combined.values.empty()) {
+            combined.values = std::move(partial.values);
+        } else if (minimum) {
+            for (size_t n = 0; n < elements; ++n) combined.values[n] = std::fmin(combined.values[n], partial.values[n]);
+        } else {
+            for (size_t n = 0; n < elements; ++n) combined.values[n] = std::fmax(combined.values[n], partial.values[n]);
+        }
+    }
+    return combined;
+}
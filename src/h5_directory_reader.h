@@ -0,0 +1,56 @@
+#ifndef H5_DIRECTORY_READER_H
+#define H5_DIRECTORY_READER_H
+
+#include "h5.h"
+#include "thread_pool.h"
+
+
+// Matrix gathered from several files, row-major with dims
+struct StackedMatrix {
+    std::vector<hsize_t> dims;
+    std::vector<double> values;
+};
+
+// Reads the same dataset from every prefix___*.h5 file in a directory. Each file
+// is opened, read and released by one task on a dedicated I/O pool, so opening
+// and metadata work for one file overlap data reads and aggregation for others.
+// With an HDF5 library that is not thread safe only the HDF5 calls are
+// serialised; aggregation still runs in parallel.
+class H5DirectoryReader {
+
+    public:
+
+        H5DirectoryReader(const std::string& directory, const std::string& file_prefix, size_t io_threads = 8);
+
+        // Matching files, sorted by name; results below follow this order
+        const std::vector<std::string>& files() const { return file_paths; }
+        size_t size() const { return file_paths.size(); }
+
+        std::vector<double> readScalars(const std::string& name);
+        std::vector<std::vector<double>> readAxes(const std::string& name);
+        std::vector<MatrixStatistics> reduceMatrices(const std::string& name);
+
+        // All files' matrices along a new leading dimension: {files, dims...}
+        StackedMatrix stackMatrices(const std::string& name);
+
+        // Element-wise minimum/maximum across files, NaN where every file holds NaN
+        StackedMatrix minimumMatrix(const std::string& name);
+        StackedMatrix maximumMatrix(const std::string& name);
+
+    protected:
+        // Run fn(reader, file_index) for every file on the pool and collect the results in file order
+        template <typename F>
+        auto forEachFile(F fn) -> std::vector<decltype(fn(std::declval<H5FileReader&>(), size_t()))>;
+
+        // Serialises HDF5 calls when the library has no lock of its own
+        std::unique_lock<std::mutex> libraryLock();
+
+        StackedMatrix combineMatrices(const std::string& name, bool minimum);
+
+        std::vector<std::string> file_paths;
+        ThreadPool pool;
+        bool library_threadsafe = false;
+        std::mutex library_mutex;
+};
+
+#endif // H5_DIRECTORY_READER_H
@@ -0,0 +1,151 @@
+#include "h5_interpolator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Corner reads per grouped read, the batch shrinks as the corner count grows with rank
+const size_t batch_corners = 1 << 16;
+
+}
+
+H5Interpolator::H5Interpolator(H5FileReader& reader, const std::string& matrix, const std::vector<std::string>& axes)
+    : reader(reader), matrix(matrix) {
+    std::vector<hsize_t> dims = reader.getMatrixDims(matrix);
+    if (dims.empty() || axes.size() != dims.size()) {
+        throw std::invalid_argument("Expected one axis per dimension of " + matrix);
+    }
+
+    for (size_t d = 0; d < axes.size(); ++d) {
+        Axis axis;
+        axis.values = reader.readMatrixAxisFromDataset(axes[d]);
+        const std::vector<double>& values = axis.values;
+        if (values.size() != dims[d]) {
+            throw std::invalid_argument("Axis " + axes[d] + " does not match dimension " + std::to_string(d) + " of " + matrix);
+        }
+        for (size_t n = 1; n < values.size(); ++n) {
+            if (!(values[n] > values[n - 1])) {
+                throw std::invalid_argument("Axis is not strictly increasing: " + axes[d]);
+            }
+        }
+
+        // Evenly spaced axes are searched by stride instead of bisection
+        if (values.size() > 1) {
+            const double step = (values.back() - values.front()) / (values.size() - 1);
+            axis.uniform = true;
+            for (size_t n = 1; n < values.size() && axis.uniform; ++n) {
+                axis.uniform = std::fabs(values[n] - values[n - 1] - step) <= 1e-9 * step;
+            }
+            axis.start = values.front();
+            axis.inverse_step = 1.0 / step;
+        }
+        this->axes.push_back(std::move(axis));
+    }
+}
+
+bool H5Interpolator::locate(const Axis& axis, double x, hsize_t& lower, double& weight) {
+    const std::vector<double>& values = axis.values;
+    const size_t n = values.size();
+    if (!(x >= values.front() && x <= values.back())) {
+        return false; // Also NaN
+    }
+    if (n == 1) {
+        lower = 0;
+        weight = 0.0;
+        return true;
+    }
+
+    size_t cell;
+    if (axis.uniform) {
+        cell = std::min(static_cast<size_t>((x - axis.start) * axis.inverse_step), n - 2);
+        // Rounding can land one cell off
+        if (x < values[cell]) {
+            cell--;
+        } else if (x > values[cell + 1]) {
+            cell++;
+        }
+    } else {
+        cell = std::upper_bound(values.begin(), values.end(), x) - values.begin();
+        cell = std::min(cell, n - 1) - 1;
+    }
+    lower = cell;
+    weight = (x - values[cell]) / (values[cell + 1] - values[cell]);
+    return true;
+}
+
+double H5Interpolator::interpolate(const std::vector<double>& point) {
+    if (point.size() != axes.size()) {
+        throw std::invalid_argument("Expected " + std::to_string(axes.size()) + " coordinates for " + matrix);
+    }
+    double value;
+    interpolateBatch(point.data(), 1, &value);
+    return value;
+}
+
+std::vector<double> H5Interpolator::interpolate(const std::vector<double>& points, size_t count) {
+    if (points.size() != count * axes.size()) {
+        throw std::invalid_argument("Expected " + std::to_string(axes.size()) + " coordinates per query for " + matrix);
+    }
+    std::vector<double> values(count);
+    interpolate(points.data(), count, values.data());
+    return values;
+}
+
+void H5Interpolator::interpolate(const double* points, size_t count, double* out) {
+    const size_t batch = std::max<size_t>(batch_corners >> axes.size(), 1);
+    for (size_t first = 0; first < count; first += batch) {
+        interpolateBatch(points + first * axes.size(), std::min(batch, count - first), out + first);
+    }
+}
+
+void H5Interpolator::interpolateBatch(const double* points, size_t count, double* out) {
+    const size_t rank = axes.size();
+    const size_t corner_count = size_t(1) << rank;
+    corners.resize(corner_count * count * rank);
+    corner_values.resize(corner_count * count);
+    weights.resize(rank * count);
+    outside.assign(count, false);
+
+    // Corner c takes the upper node on axis d when bit d of c is set
+    std::vector<hsize_t> lower(rank), upper(rank);
+    for (size_t q = 0; q < count; ++q) {
+        for (size_t d = 0; d < rank; ++d) {
+            double weight;
+            if (!locate(axes[d], points[q * rank + d], lower[d], weight)) {
+                outside[q] = true;
+                lower[d] = 0;
+                weight = 0.0;
+            }
+            upper[d] = std::min<hsize_t>(lower[d] + 1, axes[d].values.size() - 1);
+            weights[d * count + q] = weight;
+        }
+        for (size_t c = 0; c < corner_count; ++c) {
+            hsize_t* corner = &corners[(c * count + q) * rank];
+            for (size_t d = 0; d < rank; ++d) {
+                corner[d] = (c >> d) & 1 ? upper[d] : lower[d];
+            }
+        }
+    }
+
+    // Neighbouring queries share corners, the grouped read fetches each cell once
+    reader.readPointsFromMatrix(matrix, corners.data(), corner_count * count, corner_values.data());
+
+    // Collapse one axis per pass, pairing corners that differ only in that axis.
+    // Exact node hits keep their value even next to a NaN neighbour.
+    for (size_t d = 0, remaining = corner_count; d < rank; ++d, remaining /= 2) {
+        const double* w = &weights[d * count];
+        for (size_t k = 0; k < remaining / 2; ++k) {
+            const double* a = &corner_values[2 * k * count];
+            const double* b = &corner_values[(2 * k + 1) * count];
+            double* result = &corner_values[k * count];
+            for (size_t q = 0; q < count; ++q) {
+                result[q] = w[q] == 0.0 ? a[q] : w[q] == 1.0 ? b[q] : a[q] + w[q] * (b[q] - a[q]);
+            }
+        }
+    }
+
+    for (size_t q = 0; q < count; ++q) {
+        out[q] = outside[q] ? std::numeric_limits<double>::quiet_NaN() : corner_values[q];
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef H5_INTERPOLATOR_H
+#define H5_INTERPOLATOR_H
+
+#include "h5.h"
+
+
+// Multilinear interpolation of a stored matrix at physical coordinates. The matrix
+// is bound once to one axis dataset per dimension (as written by
+// writeMatrixAxisToDataset); the axes stay in memory and are searched by stride
+// when evenly spaced, by bisection otherwise. Batches fetch the 2^rank corner cells
+// of all their queries in one grouped point read, served from decoded blocks when
+// the reader has a block cache, and combine them one axis at a time.
+//
+// Axes must be strictly increasing. Queries outside an axis, or holding NaN, give
+// NaN; an axis of length one only matches its single value. Batches reuse scratch
+// buffers, so each thread binds its own interpolator.
+class H5Interpolator {
+
+    public:
+
+        H5Interpolator(H5FileReader& reader, const std::string& matrix, const std::vector<std::string>& axes);
+
+        size_t rank() const { return axes.size(); }
+        const std::vector<double>& axis(size_t d) const { return axes.at(d).values; }
+
+        double interpolate(const std::vector<double>& point);
+
+        // points holds rank coordinates per query, out one value per query
+        std::vector<double> interpolate(const std::vector<double>& points, size_t count);
+        void interpolate(const double* points, size_t count, double* out);
+
+    protected:
+        struct Axis {
+            std::vector<double> values;
+            bool uniform = false;
+            double start = 0.0;
+            double inverse_step = 0.0;
+        };
+
+        // Lower node of the cell holding x and the weight of the upper node, false outside the axis
+        static bool locate(const Axis& axis, double x, hsize_t& lower, double& weight);
+
+        void interpolateBatch(const double* points, size_t count, double* out);
+
+        H5FileReader& reader;
+        std::string matrix;
+        std::vector<Axis> axes;
+
+        // Per-batch scratch, corner-major so the kernel runs over queries
+        std::vector<hsize_t> corners;
+        std::vector<double> corner_values;
+        std::vector<double> weights;
+        std::vector<bool> outside;
+};
+
+#endif // H5_INTERPOLATOR_H
@@ -0,0 +1,153 @@
+#include "h5_sharded_writer.h"
+
+hid_t H5ShardedWriter::Shard::dataset(const std::string& name) const {
+    auto it = bands.find(name);
+    if (it == bands.end()) {
+        throw std::runtime_error("Matrix not found in shard: " + name);
+    }
+    return it->second.dataset;
+}
+
+std::pair<hsize_t, hsize_t> H5ShardedWriter::Shard::rows(const std::string& name) const {
+    auto it = bands.find(name);
+    if (it == bands.end()) {
+        throw std::runtime_error("Matrix not found in shard: " + name);
+    }
+    return {it->second.begin, it->second.end};
+}
+
+void H5ShardedWriter::Shard::writeTo4DMatrix(hid_t dataset, double value, int i, int j, int k, int l) {
+    const int row = static_cast<int>(localRow(dataset, i));
+    auto lock = owner->libraryLock();
+    writer->writeTo4DMatrix(dataset, value, row, j, k, l);
+}
+
+void H5ShardedWriter::Shard::writeTo5DMatrix(hid_t dataset, double value, int i, int j, int k, int l, int m) {
+    const int row = static_cast<int>(localRow(dataset, i));
+    auto lock = owner->libraryLock();
+    writer->writeTo5DMatrix(dataset, value, row, j, k, l, m);
+}
+
+hsize_t H5ShardedWriter::Shard::localRow(hid_t dataset, int i) const {
+    auto it = bands_by_dataset.find(dataset);
+    if (it == bands_by_dataset.end()) {
+        throw std::runtime_error("Dataset does not belong to this shard");
+    }
+    if (i < 0 || static_cast<hsize_t>(i) < it->second.begin || static_cast<hsize_t>(i) >= it->second.end) {
+        throw std::out_of_range("Row " + std::to_string(i) + " is owned by another shard");
+    }
+    return static_cast<hsize_t>(i) - it->second.begin;
+}
+
+H5ShardedWriter::H5ShardedWriter(std::string& directory, std::string& file_prefix, size_t shards) {
+    if (shards == 0) shards = 1;
+
+    master_writer = std::make_unique<H5FileWriter>(directory, file_prefix);
+    file_path = master_writer->getFilePath();
+
+    this->shards.resize(shards);
+    for (size_t index = 0; index < shards; ++index) {
+        std::string shard_prefix = file_prefix + "_shard" + std::to_string(index);
+        this->shards[index].owner = this;
+        this->shards[index].writer = std::make_unique<H5FileWriter>(directory, shard_prefix);
+    }
+
+    hbool_t threadsafe = false;
+    library_threadsafe = H5is_library_threadsafe(&threadsafe) >= 0 && threadsafe;
+}
+
+std::unique_lock<std::mutex> H5ShardedWriter::libraryLock() {
+    if (library_threadsafe) {
+        return std::unique_lock<std::mutex>();
+    }
+    return std::unique_lock<std::mutex>(library_mutex);
+}
+
+H5ShardedWriter::~H5ShardedWriter() {
+    try {
+        close();
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to close sharded file " << file_path << ": " << e.what() << std::endl;
+    }
+}
+
+H5FileWriter& H5ShardedWriter::master() {
+    if (!master_writer) {
+        throw std::runtime_error("Sharded file is closed: " + file_path);
+    }
+    return *master_writer;
+}
+
+H5ShardedWriter::Shard& H5ShardedWriter::shard(size_t index) {
+    if (index >= shards.size()) {
+        throw std::out_of_range("Shard index out of range: " + std::to_string(index));
+    }
+    return shards[index];
+}
+
+void H5ShardedWriter::generate4DMatrix(const std::string& name, size_t N, size_t M, size_t O, size_t P, const MatrixOptions& options) {
+    generateMatrix(name, {N, M, O, P}, options);
+}
+
+void H5ShardedWriter::generate5DMatrix(const std::string& name, size_t N, size_t M, size_t O, size_t P, size_t Q, const MatrixOptions& options) {
+    generateMatrix(name, {N, M, O, P, Q}, options);
+}
+
+void H5ShardedWriter::generateMatrix(const std::string& name, const std::vector<hsize_t>& dims, const MatrixOptions& options) {
+    if (!master_writer) {
+        throw std::runtime_error("Sharded file is closed: " + file_path);
+    }
+
+    // Even bands of rows; shards past the last row get none and no dataset
+    const hsize_t count = shards.size();
+    for (hsize_t index = 0; index < count; ++index) {
+        Shard::Band band;
+        band.begin = dims[0] * index / count;
+        band.end = dims[0] * (index + 1) / count;
+        if (band.end > band.begin) {
+            std::vector<hsize_t> shard_dims(dims);
+            shard_dims[0] = band.end - band.begin;
+            MatrixOptions shard_options(options);
+            if (!shard_options.chunk_dims.empty()) {
+                shard_options.chunk_dims[0] = std::min(shard_options.chunk_dims[0], shard_dims[0]);
+            }
+            H5FileWriter& writer = *shards[index].writer;
+            band.dataset = shard_dims.size() == 4
+                ? writer.generate4DMatrix(name, shard_dims[0], shard_dims[1], shard_dims[2], shard_dims[3], shard_options)
+                : writer.generate5DMatrix(name, shard_dims[0], shard_dims[1], shard_dims[2], shard_dims[3], shard_dims[4], shard_options);
+            shards[index].bands_by_dataset[band.dataset] = band;
+        }
+        shards[index].bands[name] = band;
+    }
+    matrices.push_back(ShardedMatrix{name, dims});
+}
+
+void H5ShardedWriter::enableBufferedWrites(size_t tile_elements, size_t max_tiles_per_dataset) {
+    for (auto& shard : shards) {
+        if (shard.writer) shard.writer->enableBufferedWrites(tile_elements, max_tiles_per_dataset);
+    }
+}
+
+void H5ShardedWriter::close() {
+    if (!master_writer) return;
+
+    // Shard files must be complete before anything reads through the master
+    std::vector<std::string> shard_files(shards.size());
+    for (size_t index = 0; index < shards.size(); ++index) {
+        shard_files[index] = std::filesystem::path(shards[index].writer->getFilePath()).filename().string();
+        shards[index].writer.reset();
+    }
+
+    // Source names are relative so the files can move together
+    for (const ShardedMatrix& matrix : matrices) {
+        std::vector<VirtualSource> sources;
+        for (size_t index = 0; index < shards.size(); ++index) {
+            const Shard::Band& band = shards[index].bands[matrix.name];
+            if (band.end > band.begin) {
+                sources.push_back(VirtualSource{shard_files[index], matrix.name, band.begin, band.end - band.begin});
+            }
+        }
+        master_writer->generateVirtualMatrix(matrix.name, matrix.dims, sources);
+    }
+    master_writer.reset();
+}
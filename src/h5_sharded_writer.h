@@ -0,0 +1,88 @@
+#ifndef H5_SHARDED_WRITER_H
+#define H5_SHARDED_WRITER_H
+
+#include "h5.h"
+#include <memory>
+#include <thread>
+
+
+// Splits each matrix along axis 0 into one shard file per producer thread. Shards
+// share no writer state, so every thread stages and encodes its own rows without
+// coordination. On close the master file gets a virtual dataset per matrix that
+// maps onto the shards, and H5FileReader reads it as one dataset.
+//
+// HDF5 calls still take the library's global lock in a thread safe build, and a
+// mutex of the sharded writer otherwise, so only the work outside the library
+// scales with the thread count; unbuffered point writes barely do.
+class H5ShardedWriter {
+
+    public:
+
+        // One thread's part of every matrix. Coordinates are global; axis 0 must fall in rows().
+        class Shard {
+
+            public:
+
+                hid_t dataset(const std::string& name) const;
+                std::pair<hsize_t, hsize_t> rows(const std::string& name) const; // [begin, end)
+
+                void writeTo4DMatrix(hid_t dataset, double value, int i, int j, int k, int l);
+                void writeTo5DMatrix(hid_t dataset, double value, int i, int j, int k, int l, int m);
+
+            protected:
+                friend class H5ShardedWriter;
+
+                struct Band {
+                    hid_t dataset = -1;
+                    hsize_t begin = 0;
+                    hsize_t end = 0;
+                };
+
+                hsize_t localRow(hid_t dataset, int i) const;
+
+                H5ShardedWriter* owner = nullptr;
+                std::unique_ptr<H5FileWriter> writer;
+                std::map<std::string, Band> bands;
+                std::map<hid_t, Band> bands_by_dataset;
+        };
+
+        H5ShardedWriter(std::string& directory, std::string& file_prefix, size_t shards = std::thread::hardware_concurrency());
+        ~H5ShardedWriter();
+
+        // Scalars, axes and dictionaries go straight into the master file
+        H5FileWriter& master();
+
+        size_t shardCount() const { return shards.size(); }
+        Shard& shard(size_t index);
+
+        // Create the shard datasets; call before the producer threads start
+        void generate4DMatrix(const std::string& name, size_t N, size_t M, size_t O, size_t P, const MatrixOptions& options = MatrixOptions());
+        void generate5DMatrix(const std::string& name, size_t N, size_t M, size_t O, size_t P, size_t Q, const MatrixOptions& options = MatrixOptions());
+
+        void enableBufferedWrites(size_t tile_elements = 65536, size_t max_tiles_per_dataset = 4);
+
+        // Close the shards and write the virtual datasets; the master file is complete afterwards
+        void close();
+
+        const std::string& getFilePath() const { return file_path; }
+
+    protected:
+        struct ShardedMatrix {
+            std::string name;
+            std::vector<hsize_t> dims;
+        };
+
+        void generateMatrix(const std::string& name, const std::vector<hsize_t>& dims, const MatrixOptions& options);
+
+        // Serialises shard writes when the library has no lock of its own
+        std::unique_lock<std::mutex> libraryLock();
+
+        std::unique_ptr<H5FileWriter> master_writer;
+        std::vector<Shard> shards;
+        std::vector<ShardedMatrix> matrices;
+        std::string file_path;
+        bool library_threadsafe = false;
+        std::mutex library_mutex;
+};
+
+#endif // H5_SHARDED_WRITER_H
@@ -0,0 +1,154 @@
+#include "h5_stats.h"
+
+#include <condition_variable>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char* operationName(size_t operation) {
+    switch (static_cast<H5Operation>(operation)) {
+        case H5Operation::Create: return "create";
+        case H5Operation::Write: return "write";
+        case H5Operation::Read: return "read";
+        default: return "unknown";
+    }
+}
+
+struct PeriodicDump {
+    std::mutex mutex;
+    std::condition_variable stop;
+    bool stopping = false;
+    std::thread thread;
+};
+
+std::mutex dump_mutex;
+std::unique_ptr<PeriodicDump> dump;
+
+#ifdef HDF5MT_ENABLE_STATS
+// Shards outlive their threads so counts from finished threads are kept
+std::mutex shard_mutex;
+std::vector<std::unique_ptr<H5Stats::Shard>>& shards() {
+    static std::vector<std::unique_ptr<H5Stats::Shard>> registry;
+    return registry;
+}
+#endif
+
+}
+
+double H5OperationStats::latencyPercentile(double fraction) const {
+    uint64_t total = 0;
+    for (uint64_t count : latency_histogram) total += count;
+    if (total == 0) return 0.0;
+
+    uint64_t target = static_cast<uint64_t>(fraction * total);
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < buckets; ++bucket) {
+        seen += latency_histogram[bucket];
+        if (seen > target) {
+            return static_cast<double>(uint64_t(1) << bucket) * 1e-9;
+        }
+    }
+    return static_cast<double>(uint64_t(1) << (buckets - 1)) * 1e-9;
+}
+
+void H5StatsSnapshot::print(std::ostream& out) const {
+    for (size_t op = 0; op < operations.size(); ++op) {
+        const H5OperationStats& stats = operations[op];
+        out << std::left << std::setw(8) << operationName(op)
+            << " calls " << stats.calls
+            << " bytes " << stats.bytes
+            << " total " << stats.total_seconds << "s"
+            << " hdf5 " << stats.hdf5_seconds << "s"
+            << " own " << stats.ownSeconds() << "s"
+            << " p50 " << stats.latencyPercentile(0.50) * 1e6 << "us"
+            << " p99 " << stats.latencyPercentile(0.99) * 1e6 << "us" << std::endl;
+    }
+}
+
+#ifdef HDF5MT_ENABLE_STATS
+
+H5Stats::ThreadState& H5Stats::thread() {
+    thread_local ThreadState state;
+    if (state.shard == nullptr) {
+        std::lock_guard<std::mutex> lock(shard_mutex);
+        shards().push_back(std::make_unique<Shard>());
+        state.shard = shards().back().get();
+    }
+    return state;
+}
+
+H5StatsSnapshot H5Stats::snapshot() {
+    H5StatsSnapshot snapshot;
+    std::lock_guard<std::mutex> lock(shard_mutex);
+    for (auto& shard : shards()) {
+        for (size_t op = 0; op < snapshot.operations.size(); ++op) {
+            H5OperationStats& stats = snapshot.operations[op];
+            stats.calls += shard->calls[op].load(std::memory_order_relaxed);
+            stats.bytes += shard->bytes[op].load(std::memory_order_relaxed);
+            stats.total_seconds += shard->total_ns[op].load(std::memory_order_relaxed) * 1e-9;
+            stats.hdf5_seconds += shard->hdf5_ns[op].load(std::memory_order_relaxed) * 1e-9;
+            for (int bucket = 0; bucket < H5OperationStats::buckets; ++bucket) {
+                stats.latency_histogram[bucket] += shard->histogram[op][bucket].load(std::memory_order_relaxed);
+            }
+        }
+    }
+    return snapshot;
+}
+
+void H5Stats::reset() {
+    // Racy against in-flight operations by design; counts are approximate across a reset
+    std::lock_guard<std::mutex> lock(shard_mutex);
+    for (auto& shard : shards()) {
+        for (size_t op = 0; op < static_cast<size_t>(H5Operation::Count); ++op) {
+            shard->calls[op].store(0, std::memory_order_relaxed);
+            shard->bytes[op].store(0, std::memory_order_relaxed);
+            shard->total_ns[op].store(0, std::memory_order_relaxed);
+            shard->hdf5_ns[op].store(0, std::memory_order_relaxed);
+            for (int bucket = 0; bucket < H5OperationStats::buckets; ++bucket) {
+                shard->histogram[op][bucket].store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+#else
+
+H5StatsSnapshot H5Stats::snapshot() {
+    return H5StatsSnapshot();
+}
+
+void H5Stats::reset() {
+}
+
+#endif
+
+void H5Stats::startPeriodicDump(std::ostream& out, std::chrono::milliseconds interval) {
+    stopPeriodicDump();
+
+    std::lock_guard<std::mutex> lock(dump_mutex);
+    dump = std::make_unique<PeriodicDump>();
+    PeriodicDump* state = dump.get();
+    state->thread = std::thread([state, &out, interval]() {
+        std::unique_lock<std::mutex> wait_lock(state->mutex);
+        while (!state->stop.wait_for(wait_lock, interval, [state]() { return state->stopping; })) {
+            snapshot().print(out);
+        }
+    });
+}
+
+void H5Stats::stopPeriodicDump() {
+    std::lock_guard<std::mutex> lock(dump_mutex);
+    if (!dump) return;
+    {
+        std::lock_guard<std::mutex> stop_lock(dump->mutex);
+        dump->stopping = true;
+    }
+    dump->stop.notify_all();
+    dump->thread.join();
+    dump.reset();
+}
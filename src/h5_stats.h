@@ -0,0 +1,136 @@
+#ifndef H5_STATS_H
+#define H5_STATS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+
+
+// Hot-path instrumentation for H5FileWriter/H5FileReader. Counters live in
+// per-thread shards and are only merged when a snapshot is taken. Building
+// without HDF5MT_ENABLE_STATS compiles every probe out; the snapshot API then
+// reports zeros.
+
+enum class H5Operation { Create, Write, Read, Count };
+
+struct H5OperationStats {
+    static constexpr int buckets = 40; // Bucket b holds latencies in [2^(b-1), 2^b) ns
+
+    uint64_t calls = 0;
+    uint64_t bytes = 0;
+    double total_seconds = 0.0;     // Whole call, our code included
+    // Inside instrumented HDF5 calls. A thread safe library serialises calls on its own
+    // global lock, and time waiting for it is counted here too.
+    double hdf5_seconds = 0.0;
+    std::array<uint64_t, buckets> latency_histogram = {};
+
+    double ownSeconds() const { return total_seconds - hdf5_seconds; }
+    double latencyPercentile(double fraction) const; // Upper bucket bound, in seconds
+};
+
+struct H5StatsSnapshot {
+    std::array<H5OperationStats, static_cast<size_t>(H5Operation::Count)> operations;
+
+    const H5OperationStats& operator[](H5Operation operation) const { return operations[static_cast<size_t>(operation)]; }
+    void print(std::ostream& out) const;
+};
+
+class H5Stats {
+
+    public:
+
+        static H5StatsSnapshot snapshot();
+        static void reset();
+
+        // Print a snapshot to out every interval until stopped
+        static void startPeriodicDump(std::ostream& out, std::chrono::milliseconds interval);
+        static void stopPeriodicDump();
+
+#ifdef HDF5MT_ENABLE_STATS
+        struct Shard {
+            std::atomic<uint64_t> calls[static_cast<size_t>(H5Operation::Count)] = {};
+            std::atomic<uint64_t> bytes[static_cast<size_t>(H5Operation::Count)] = {};
+            std::atomic<uint64_t> total_ns[static_cast<size_t>(H5Operation::Count)] = {};
+            std::atomic<uint64_t> hdf5_ns[static_cast<size_t>(H5Operation::Count)] = {};
+            std::atomic<uint64_t> histogram[static_cast<size_t>(H5Operation::Count)][H5OperationStats::buckets] = {};
+        };
+
+        struct ThreadState {
+            Shard* shard = nullptr;
+            int depth = 0; // Nested operations are folded into the outermost one
+            uint64_t hdf5_ns = 0;
+        };
+
+        static ThreadState& thread();
+
+        // Single writer per shard, so a plain load/store pair is enough
+        static void add(std::atomic<uint64_t>& counter, uint64_t value) {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        static uint64_t nanoseconds(std::chrono::steady_clock::duration duration) {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+        }
+
+        template <typename F>
+        static auto libraryCall(F&& call) -> decltype(call()) {
+            ThreadState& state = thread();
+            auto start = std::chrono::steady_clock::now();
+            auto result = call();
+            if (state.depth > 0) {
+                state.hdf5_ns += nanoseconds(std::chrono::steady_clock::now() - start);
+            }
+            return result;
+        }
+#endif
+};
+
+#ifdef HDF5MT_ENABLE_STATS
+
+class H5OperationScope {
+
+    public:
+
+        H5OperationScope(H5Operation operation, uint64_t bytes) : state(H5Stats::thread()), operation(operation), bytes(bytes) {
+            if (state.depth++ == 0) {
+                state.hdf5_ns = 0;
+                start = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~H5OperationScope() {
+            if (--state.depth > 0) return;
+
+            uint64_t elapsed = H5Stats::nanoseconds(std::chrono::steady_clock::now() - start);
+            int bucket = 0;
+            while (bucket < H5OperationStats::buckets - 1 && (elapsed >> bucket) != 0) bucket++;
+
+            const size_t op = static_cast<size_t>(operation);
+            H5Stats::Shard& shard = *state.shard;
+            H5Stats::add(shard.calls[op], 1);
+            H5Stats::add(shard.bytes[op], bytes);
+            H5Stats::add(shard.total_ns[op], elapsed);
+            H5Stats::add(shard.hdf5_ns[op], state.hdf5_ns);
+            H5Stats::add(shard.histogram[op][bucket], 1);
+        }
+
+    protected:
+        H5Stats::ThreadState& state;
+        H5Operation operation;
+        uint64_t bytes;
+        std::chrono::steady_clock::time_point start;
+};
+
+#define H5_STATS_OPERATION(operation, bytes) H5OperationScope h5_stats_scope_(operation, bytes)
+#define H5_STATS_LIBRARY(call) H5Stats::libraryCall([&]() { return call; })
+
+#else
+
+#define H5_STATS_OPERATION(operation, bytes) ((void)0)
+#define H5_STATS_LIBRARY(call) (call)
+
+#endif
+
+#endif // H5_STATS_H
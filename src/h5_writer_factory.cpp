@@ -0,0 +1,122 @@
+#include "h5_writer_factory.h"
+
+#include <cstdio>
+#include <fstream>
+
+H5WriterFactory::H5WriterFactory(const std::string& directory, const std::string& file_prefix, size_t pool_size, WriterStorage storage)
+    : directory(directory), file_prefix(file_prefix), storage(storage), pool_size(pool_size) {
+    // Random bits and the clock keep concurrent runs apart, the counter keeps files of one run apart
+    std::random_device device;
+    uint64_t bits = (static_cast<uint64_t>(device()) << 32) | device();
+    bits ^= static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+    char text[13];
+    std::snprintf(text, sizeof(text), "%012llx", static_cast<unsigned long long>(bits & 0xffffffffffffULL));
+    run_id = text;
+
+    // One check for every writer; a probe file tests write access without touching permissions
+    if (storage != WriterStorage::Memory) {
+        if (!std::filesystem::is_directory(directory)) {
+            throw std::runtime_error("Directory does not exist: " + directory);
+        }
+        std::string probe = directory + "/" + file_prefix + "___" + run_id + ".probe";
+        bool writable = static_cast<bool>(std::ofstream(probe));
+        std::error_code ec;
+        std::filesystem::remove(probe, ec);
+        if (!writable) {
+            throw std::runtime_error("No write permissions in directory: " + directory);
+        }
+    }
+
+    property_lists = H5FileWriter::createPropertyLists(storage);
+    for (hid_t list : property_lists) {
+        if (list < 0) {
+            for (hid_t created : property_lists) {
+                if (created >= 0) H5Pclose(created);
+            }
+            throw std::runtime_error("Failed to create property lists for writers in " + directory);
+        }
+    }
+
+    hbool_t threadsafe = false;
+    if (pool_size > 0 && H5is_library_threadsafe(&threadsafe) >= 0 && threadsafe) {
+        pool_thread = std::thread(&H5WriterFactory::refillPool, this);
+    }
+}
+
+H5WriterFactory::~H5WriterFactory() {
+    if (pool_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            pool_stopping = true;
+        }
+        pool_taken.notify_all();
+        pool_thread.join();
+    }
+
+    // Unused files are empty, leaving them would add stray results to the directory
+    for (PendingFile& pending : pool) {
+        H5Fclose(pending.file);
+        if (storage != WriterStorage::Memory) {
+            std::error_code ec;
+            std::filesystem::remove(pending.path, ec);
+        }
+    }
+
+    // Writers still open keep their own references
+    for (hid_t list : property_lists) H5Pclose(list);
+}
+
+std::unique_ptr<H5FileWriter> H5WriterFactory::create() {
+    PendingFile pending{-1, std::string()};
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        if (!pool.empty()) {
+            pending = std::move(pool.front());
+            pool.pop_front();
+        }
+    }
+    if (pending.file >= 0) {
+        pool_taken.notify_one();
+    } else {
+        pending = createFile();
+    }
+    return std::unique_ptr<H5FileWriter>(new H5FileWriter(pending.file, pending.path, storage, property_lists));
+}
+
+H5WriterFactory::PendingFile H5WriterFactory::createFile() {
+    // A name left behind by another process is skipped rather than truncated
+    const unsigned flags = storage == WriterStorage::Memory ? H5F_ACC_TRUNC : H5F_ACC_EXCL;
+    for (int attempt = 0; attempt < 16; ++attempt) {
+        std::string number = std::to_string(counter.fetch_add(1, std::memory_order_relaxed));
+        if (number.size() < 6) number.insert(0, 6 - number.size(), '0');
+        std::string path = directory + "/" + file_prefix + "___" + run_id + "-" + number + ".h5";
+
+        hid_t file = H5_STATS_LIBRARY(H5Fcreate(path.c_str(), flags, property_lists[0], property_lists[1]));
+        if (file >= 0) {
+            return PendingFile{file, path};
+        }
+        if (storage == WriterStorage::Memory || !std::filesystem::exists(path)) {
+            throw std::runtime_error("Failed to create HDF5 file: " + path);
+        }
+    }
+    throw std::runtime_error("No free file name for run " + run_id + " in " + directory);
+}
+
+void H5WriterFactory::refillPool() {
+    std::unique_lock<std::mutex> lock(pool_mutex);
+    for (;;) {
+        pool_taken.wait(lock, [this]() { return pool_stopping || pool.size() < pool_size; });
+        if (pool_stopping) return;
+
+        lock.unlock();
+        PendingFile pending{-1, std::string()};
+        try {
+            pending = createFile();
+        } catch (const std::exception&) {
+            // Stop refilling; create() then tries inline and reports the error to its caller
+            return;
+        }
+        lock.lock();
+        pool.push_back(std::move(pending));
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef H5_WRITER_FACTORY_H
+#define H5_WRITER_FACTORY_H
+
+#include "h5.h"
+
+
+// Creates H5FileWriters for many files of one directory and prefix. The directory
+// is checked once, property lists are created once and shared by every writer, and
+// files are named prefix___<run id>-<counter>.h5 so names never repeat within a run
+// and sort in creation order. With a pool size, that many files are created ahead on
+// a background thread and create() only hands one out. The pool needs a thread safe
+// HDF5 library; without one files are always created inline.
+class H5WriterFactory {
+
+    public:
+
+        H5WriterFactory(const std::string& directory, const std::string& file_prefix, size_t pool_size = 0, WriterStorage storage = WriterStorage::Disk);
+        ~H5WriterFactory(); // Deletes pooled files that were never handed out
+
+        H5WriterFactory(const H5WriterFactory&) = delete;
+        H5WriterFactory& operator=(const H5WriterFactory&) = delete;
+
+        // Safe to call from several threads with a thread safe HDF5 library
+        std::unique_ptr<H5FileWriter> create();
+
+        const std::string& runId() const { return run_id; }
+        uint64_t created() const { return counter.load(std::memory_order_relaxed); } // Files created so far, pooled ones included
+
+    protected:
+        struct PendingFile {
+            hid_t file;
+            std::string path;
+        };
+
+        PendingFile createFile();
+        void refillPool();
+
+        std::string directory;
+        std::string file_prefix;
+        std::string run_id;
+        WriterStorage storage;
+        H5FileWriter::PropertyLists property_lists;
+        std::atomic<uint64_t> counter{0};
+
+        // Files created ahead, refilled by pool_thread up to pool_size
+        size_t pool_size;
+        std::deque<PendingFile> pool;
+        std::mutex pool_mutex;
+        std::condition_variable pool_taken;
+        std::thread pool_thread;
+        bool pool_stopping = false;
+};
+
+#endif // H5_WRITER_FACTORY_H
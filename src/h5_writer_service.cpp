@@ -0,0 +1,251 @@
+#include "h5_writer_service.h"
+
+struct H5WriterService::Command {
+    enum class Kind { Scalar, Axis, Matrix, Flush, Stop };
+
+    Kind kind;
+    std::string name;
+    double value = 0.0;
+    std::vector<double> axis;
+    std::vector<size_t> dims;
+    MatrixOptions options;
+    std::promise<hid_t> matrix_created;
+    std::promise<void> done;
+};
+
+H5WriterService::H5WriterService(std::string& directory, std::string& file_prefix, size_t queue_capacity)
+    : queue(queue_capacity) {
+    // The writer is created on the I/O thread so every HDF5 call happens there
+    std::promise<void> started;
+    std::future<void> ready = started.get_future();
+    io_thread = std::thread(&H5WriterService::run, this, directory, file_prefix, std::move(started));
+    try {
+        ready.get();
+    } catch (...) {
+        io_thread.join();
+        throw;
+    }
+}
+
+H5WriterService::~H5WriterService() {
+    auto command = std::make_unique<Command>();
+    command->kind = Command::Kind::Stop;
+    submitCommand(std::move(command));
+    io_thread.join();
+}
+
+void H5WriterService::writeScalarToDataset(const std::string& name, double value) {
+    auto command = std::make_unique<Command>();
+    command->kind = Command::Kind::Scalar;
+    command->name = name;
+    command->value = value;
+    submitCommand(std::move(command));
+}
+
+void H5WriterService::writeMatrixAxisToDataset(const std::string& name, const std::vector<double>& axis) {
+    auto command = std::make_unique<Command>();
+    command->kind = Command::Kind::Axis;
+    command->name = name;
+    command->axis = axis;
+    submitCommand(std::move(command));
+}
+
+std::future<hid_t> H5WriterService::generate4DMatrix(const std::string& name, size_t N, size_t M, size_t O, size_t P, const MatrixOptions& options) {
+    auto command = std::make_unique<Command>();
+    command->kind = Command::Kind::Matrix;
+    command->name = name;
+    command->dims = {N, M, O, P};
+    command->options = options;
+    std::future<hid_t> result = command->matrix_created.get_future();
+    submitCommand(std::move(command));
+    return result;
+}
+
+std::future<hid_t> H5WriterService::generate5DMatrix(const std::string& name, size_t N, size_t M, size_t O, size_t P, size_t Q, const MatrixOptions& options) {
+    auto command = std::make_unique<Command>();
+    command->kind = Command::Kind::Matrix;
+    command->name = name;
+    command->dims = {N, M, O, P, Q};
+    command->options = options;
+    std::future<hid_t> result = command->matrix_created.get_future();
+    submitCommand(std::move(command));
+    return result;
+}
+
+void H5WriterService::writeTo4DMatrix(hid_t dataset, double value, int i, int j, int k, int l) {
+    WriteRecord record;
+    record.dataset = dataset;
+    record.value = value;
+    record.rank = 4;
+    record.offset[0] = static_cast<hsize_t>(i);
+    record.offset[1] = static_cast<hsize_t>(j);
+    record.offset[2] = static_cast<hsize_t>(k);
+    record.offset[3] = static_cast<hsize_t>(l);
+    submit(record);
+}
+
+void H5WriterService::writeTo5DMatrix(hid_t dataset, double value, int i, int j, int k, int l, int m) {
+    WriteRecord record;
+    record.dataset = dataset;
+    record.value = value;
+    record.rank = 5;
+    record.offset[0] = static_cast<hsize_t>(i);
+    record.offset[1] = static_cast<hsize_t>(j);
+    record.offset[2] = static_cast<hsize_t>(k);
+    record.offset[3] = static_cast<hsize_t>(l);
+    record.offset[4] = static_cast<hsize_t>(m);
+    submit(record);
+}
+
+std::future<void> H5WriterService::flush() {
+    auto command = std::make_unique<Command>();
+    command->kind = Command::Kind::Flush;
+    std::future<void> result = command->done.get_future();
+    submitCommand(std::move(command));
+    return result;
+}
+
+void H5WriterService::submitCommand(std::unique_ptr<Command> command) {
+    WriteRecord record;
+    record.command = std::move(command);
+    submit(record);
+}
+
+void H5WriterService::submit(WriteRecord& record) {
+    // Backpressure: spin briefly, then back off while the I/O thread drains the queue
+    for (unsigned attempt = 0; !queue.tryPush(record); ++attempt) {
+        if (consumer_sleeping.load()) {
+            wake.notify_one();
+        }
+        if (attempt < 64) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (consumer_sleeping.load()) {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        wake.notify_one();
+    }
+}
+
+void H5WriterService::run(std::string directory, std::string file_prefix, std::promise<void> started) {
+    std::unique_ptr<H5FileWriter> writer;
+    try {
+        writer = std::make_unique<H5FileWriter>(directory, file_prefix);
+        writer->enableBufferedWrites();
+    } catch (...) {
+        started.set_exception(std::current_exception());
+        return;
+    }
+    started.set_value();
+
+    WriteRecord record;
+    while (!stopping) {
+        if (queue.tryPop(record)) {
+            execute(*writer, record);
+            continue;
+        }
+
+        // Nothing queued: spin a little before parking
+        bool popped = false;
+        for (int attempt = 0; attempt < 64 && !popped; ++attempt) {
+            std::this_thread::yield();
+            popped = queue.tryPop(record);
+        }
+        if (popped) {
+            execute(*writer, record);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        consumer_sleeping.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (queue.tryPop(record)) {
+            consumer_sleeping.store(false);
+            lock.unlock();
+            execute(*writer, record);
+            continue;
+        }
+        wake.wait_for(lock, std::chrono::milliseconds(1));
+        consumer_sleeping.store(false);
+    }
+
+    // Destroying the writer flushes staged tiles and closes the file
+    writer.reset();
+}
+
+void H5WriterService::execute(H5FileWriter& writer, WriteRecord& record) {
+    if (!record.command) {
+        try {
+            if (record.rank == 4) {
+                writer.writeTo4DMatrix(record.dataset, record.value, static_cast<int>(record.offset[0]), static_cast<int>(record.offset[1]),
+                                       static_cast<int>(record.offset[2]), static_cast<int>(record.offset[3]));
+            } else {
+                writer.writeTo5DMatrix(record.dataset, record.value, static_cast<int>(record.offset[0]), static_cast<int>(record.offset[1]),
+                                       static_cast<int>(record.offset[2]), static_cast<int>(record.offset[3]), static_cast<int>(record.offset[4]));
+            }
+        } catch (...) {
+            if (!error) error = std::current_exception();
+        }
+        return;
+    }
+
+    std::unique_ptr<Command> command = std::move(record.command);
+    switch (command->kind) {
+        case Command::Kind::Scalar:
+            try {
+                writer.writeScalarToDataset(command->name, command->value);
+            } catch (...) {
+                if (!error) error = std::current_exception();
+            }
+            break;
+        case Command::Kind::Axis:
+            try {
+                writer.writeMatrixAxisToDataset(command->name, command->axis);
+            } catch (...) {
+                if (!error) error = std::current_exception();
+            }
+            break;
+        case Command::Kind::Matrix:
+            try {
+                const std::vector<size_t>& d = command->dims;
+                hid_t dataset = d.size() == 4
+                    ? writer.generate4DMatrix(command->name, d[0], d[1], d[2], d[3], command->options)
+                    : writer.generate5DMatrix(command->name, d[0], d[1], d[2], d[3], d[4], command->options);
+                command->matrix_created.set_value(dataset);
+            } catch (...) {
+                command->matrix_created.set_exception(std::current_exception());
+            }
+            break;
+        case Command::Kind::Flush:
+            try {
+                writer.flush();
+            } catch (...) {
+                if (!error) error = std::current_exception();
+            }
+            if (error) {
+                command->done.set_exception(error);
+                error = nullptr;
+            } else {
+                command->done.set_value();
+            }
+            break;
+        case Command::Kind::Stop:
+            // No flush is left to hand the error to, report it like ~H5FileWriter does
+            if (error) {
+                try {
+                    std::rethrow_exception(error);
+                } catch (const std::exception& e) {
+                    std::cerr << "Failed to write to " << writer.getFilePath() << ": " << e.what() << std::endl;
+                } catch (...) {
+                    std::cerr << "Failed to write to " << writer.getFilePath() << std::endl;
+                }
+                error = nullptr;
+            }
+            stopping = true;
+            break;
+    }
+}
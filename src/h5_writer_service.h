@@ -0,0 +1,133 @@
+#ifndef H5_WRITER_SERVICE_H
+#define H5_WRITER_SERVICE_H
+
+#include "h5.h"
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+
+// Bounded multi-producer queue (Vyukov ring): producers and the consumer only
+// touch per-cell sequence numbers, so neither side takes a lock.
+template <typename T>
+class BoundedQueue {
+
+    public:
+
+        explicit BoundedQueue(size_t capacity) {
+            size_t size = 2;
+            while (size < capacity) size <<= 1;
+            mask = size - 1;
+            cells.reset(new Cell[size]);
+            for (size_t n = 0; n < size; ++n) {
+                cells[n].sequence.store(n, std::memory_order_relaxed);
+            }
+        }
+
+        bool tryPush(T& value) {
+            size_t position = tail.load(std::memory_order_relaxed);
+            for (;;) {
+                Cell& cell = cells[position & mask];
+                size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+                if (difference == 0) {
+                    if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        cell.value = std::move(value);
+                        cell.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (difference < 0) {
+                    return false; // Full
+                } else {
+                    position = tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool tryPop(T& value) {
+            size_t position = head.load(std::memory_order_relaxed);
+            for (;;) {
+                Cell& cell = cells[position & mask];
+                size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+                if (difference == 0) {
+                    if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        value = std::move(cell.value);
+                        cell.sequence.store(position + mask + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (difference < 0) {
+                    return false; // Empty
+                } else {
+                    position = head.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+    protected:
+        struct Cell {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        std::unique_ptr<Cell[]> cells;
+        size_t mask;
+        alignas(64) std::atomic<size_t> tail{0};
+        alignas(64) std::atomic<size_t> head{0};
+};
+
+
+// Owns one H5FileWriter on a dedicated I/O thread. Compute threads only enqueue
+// write records and never call into HDF5 themselves.
+class H5WriterService {
+
+    public:
+
+        H5WriterService(std::string& directory, std::string& file_prefix, size_t queue_capacity = 65536);
+        ~H5WriterService();
+
+        void writeScalarToDataset(const std::string& name, double value);
+        void writeMatrixAxisToDataset(const std::string& name, const std::vector<double>& axis);
+
+        std::future<hid_t> generate4DMatrix(const std::string& name, size_t N, size_t M, size_t O, size_t P, const MatrixOptions& options = MatrixOptions());
+        std::future<hid_t> generate5DMatrix(const std::string& name, size_t N, size_t M, size_t O, size_t P, size_t Q, const MatrixOptions& options = MatrixOptions());
+
+        void writeTo4DMatrix(hid_t dataset, double value, int i, int j, int k, int l);
+        void writeTo5DMatrix(hid_t dataset, double value, int i, int j, int k, int l, int m);
+
+        // Completes once every record submitted before it is in the file
+        std::future<void> flush();
+
+    protected:
+        struct Command; // Anything that is not a matrix point write
+
+        struct WriteRecord {
+            hid_t dataset = -1;
+            double value = 0.0;
+            int rank = 0;
+            hsize_t offset[5] = {};
+            std::unique_ptr<Command> command;
+        };
+
+        void submit(WriteRecord& record);
+        void submitCommand(std::unique_ptr<Command> command);
+        void run(std::string directory, std::string file_prefix, std::promise<void> started);
+        void execute(H5FileWriter& writer, WriteRecord& record);
+
+        BoundedQueue<WriteRecord> queue;
+        std::thread io_thread;
+        bool stopping = false; // Only touched by the I/O thread
+
+        // Parking for the I/O thread when the queue runs dry
+        std::atomic<bool> consumer_sleeping{false};
+        std::mutex wake_mutex;
+        std::condition_variable wake;
+
+        std::exception_ptr error; // First failure since the last flush, I/O thread only
+};
+
+#endif // H5_WRITER_SERVICE_H
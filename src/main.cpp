@@ -1,4 +1,8 @@
 #include "h5.h"
+#include "h5_writer_service.h"
+#include "h5_sharded_writer.h"
+#include "h5_directory_reader.h"
+#include "h5_interpolator.h"
 
 #include <thread>
 #include <future>
@@ -30,6 +34,509 @@ void multiThreadedWrite(int threads){
     }
 }
 
+void multiThreadedServiceWrite(int threads){
+
+    if (threads < 1) {threads = 1;}
+
+    std::string directory = "C:/debug";
+    std::string file_prefix = "test";
+    H5WriterService service(directory, file_prefix);
+    service.writeScalarToDataset("scalar", 3.14);
+    hid_t matrix = service.generate4DMatrix("matrix", threads, 10, 10, 10).get();
+
+    // Compute threads only enqueue; the service thread does all HDF5 calls
+    std::vector<std::future<void>> futures;
+    for(int i = 0; i < threads; i++){
+        futures.push_back(std::async(std::launch::async, [&service, matrix, i](){
+            for(int j = 0; j < 10; j++){
+                for(int k = 0; k < 10; k++){
+                    for(int l = 0; l < 10; l++){
+                        service.writeTo4DMatrix(matrix, i + j + k + l, i, j, k, l);
+                    }
+                }
+            }
+        }));
+    }
+
+    for(auto& f : futures){
+        f.get();
+    }
+    service.flush().get();
+}
+
+std::string multiThreadedShardedWrite(int threads){
+
+    if (threads < 1) {threads = 1;}
+
+    std::string directory = "C:/debug";
+    std::string file_prefix = "test";
+    H5ShardedWriter sharded(directory, file_prefix, threads);
+    sharded.master().writeScalarToDataset("scalar", 3.14);
+    sharded.generate4DMatrix("matrix", threads, 10, 10, 10);
+
+    // Each thread fills the rows of its own shard file
+    std::vector<std::future<void>> futures;
+    for(int i = 0; i < threads; i++){
+        futures.push_back(std::async(std::launch::async, [&sharded, i](){
+            H5ShardedWriter::Shard& shard = sharded.shard(i);
+            hid_t matrix = shard.dataset("matrix");
+            for(int j = 0; j < 10; j++){
+                for(int k = 0; k < 10; k++){
+                    for(int l = 0; l < 10; l++){
+                        shard.writeTo4DMatrix(matrix, i + j + k + l, i, j, k, l);
+                    }
+                }
+            }
+        }));
+    }
+
+    for(auto& f : futures){
+        f.get();
+    }
+    sharded.close();
+    return sharded.getFilePath();
+}
+
+// Round-trip checks through H5FileReader, each throws on a mismatch
+void check(bool condition, const std::string& what){
+    if (!condition) {
+        throw std::runtime_error("Round trip failed: " + what);
+    }
+}
+
+// Whole dataset through the plain HDF5 API, the reference for the reader's own read paths
+std::vector<double> plainRead(const std::string& path, const std::string& name, hid_t fapl = H5P_DEFAULT){
+    hid_t file = H5Fopen(path.c_str(), H5F_ACC_RDONLY, fapl);
+    check(file >= 0, "plain open of " + path);
+    hid_t dataset = H5Dopen(file, name.c_str(), H5P_DEFAULT);
+    hid_t dataspace = dataset < 0 ? -1 : H5Dget_space(dataset);
+    std::vector<double> values(dataspace < 0 ? 0 : H5Sget_simple_extent_npoints(dataspace));
+    herr_t status = dataspace < 0 ? -1 : H5Dread(dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, values.data());
+    if (dataspace >= 0) H5Sclose(dataspace);
+    if (dataset >= 0) H5Dclose(dataset);
+    H5Fclose(file);
+    check(status >= 0, "plain read of " + name);
+    return values;
+}
+
+// 4D matrix with a distinct value per element, linear in the indices; returns the file path
+std::string writeSampleMatrix(const std::string& name, const MatrixOptions& options = MatrixOptions(), const std::vector<std::vector<double>>& axes = {}){
+    std::string directory = "C:/debug";
+    std::string file_prefix = "test";
+    auto h = H5FileWriter(directory, file_prefix);
+    for (size_t d = 0; d < axes.size(); d++) {
+        h.writeMatrixAxisToDataset(name + "_axis" + std::to_string(d), axes[d]);
+    }
+    hid_t matrix = h.generate4DMatrix(name, 3, 4, 5, 6, options);
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 4; j++) {
+            for (int k = 0; k < 5; k++) {
+                for (int l = 0; l < 6; l++) {
+                    h.writeTo4DMatrix(matrix, i * 1000.0 + j * 100.0 + k * 10.0 + l, i, j, k, l);
+                }
+            }
+        }
+    }
+    return h.getFilePath();
+}
+
+void memoryMappingRoundTrip(){
+    std::string path = writeSampleMatrix("mapped");
+    std::vector<double> expected = plainRead(path, "mapped");
+
+    // Mapped and plain reads of a contiguous matrix must agree on every path
+    for (bool mapping : {true, false}) {
+        H5FileReader reader(path);
+        reader.setMemoryMapping(mapping);
+        std::vector<double> values(expected.size());
+        reader.readMatrix("mapped", values.data());
+        check(values == expected, mapping ? "mapped matrix" : "unmapped matrix");
+        check(reader.readPointFromMatrix("mapped", 2, 3, 4, 5) == expected.back(), "mapped point");
+        auto handle = reader.openMatrix<4>("mapped");
+        check(handle.read(1, 2, 3, 4) == expected[((1 * 4 + 2) * 5 + 3) * 6 + 4], "mapped handle");
+    }
+}
+
+void blockCacheRoundTrip(){
+    MatrixOptions options;
+    options.chunked = true; // Memory mapped contiguous matrices bypass the cache
+    options.chunk_dims = {1, 2, 5, 3};
+    std::string path = writeSampleMatrix("cached", options);
+    std::vector<double> expected = plainRead(path, "cached");
+
+    // Every slice twice, so the second pass is served from cached blocks
+    H5BlockCache cache(1 << 20);
+    H5FileReader cached(path);
+    cached.setBlockCache(&cache);
+    cached.setReadahead(2);
+    H5FileReader uncached(path);
+    for (int pass = 0; pass < 2; pass++) {
+        for (int k = 0; k < 5; k++) {
+            for (int l = 0; l < 6; l++) {
+                auto slice = cached.read2DSliceFromMatrix("cached", k, l);
+                check(slice == uncached.read2DSliceFromMatrix("cached", k, l), "cached slice");
+                check(slice[2][3] == expected[((2 * 4 + 3) * 5 + k) * 6 + l], "cached slice value");
+            }
+        }
+    }
+    check(cache.stats().hits > 0, "block cache hits");
+}
+
+void sliceRoundTrip(){
+    std::string path = writeSampleMatrix("sliced");
+    std::vector<double> expected = plainRead(path, "sliced");
+    auto at = [&expected](int i, int j, int k, int l) { return expected[((i * 4 + j) * 5 + k) * 6 + l]; };
+
+    H5FileReader reader(path);
+    std::vector<double> buffer;
+
+    // Axes in view order may be transposed against the file
+    SliceView view = reader.readSlice("sliced", {3, 1}, {1, 0, 2, 0}, buffer);
+    check(view.rank == 2 && view.extents[0] == 6 && view.extents[1] == 4, "transposed slice shape");
+    bool matches = true;
+    for (int l = 0; l < 6; l++) {
+        for (int j = 0; j < 4; j++) {
+            matches = matches && view(l, j) == at(1, j, 2, l) && view.data[l * view.strides[0] + j * view.strides[1]] == view(l, j);
+        }
+    }
+    check(matches, "transposed slice values");
+
+    // Three free axes into caller memory, and a smaller slice reusing the grown buffer
+    std::vector<double> out(3 * 5 * 6);
+    view = reader.readSlice("sliced", {0, 2, 3}, {0, 3, 0, 0}, out.data());
+    check(view.data == out.data() && view(2, 4, 5) == at(2, 3, 4, 5) && view(1, 0, 3) == at(1, 3, 0, 3), "3D slice");
+    const double* grown = buffer.data();
+    view = reader.readSlice("sliced", {2}, {2, 1, 0, 4}, buffer);
+    check(view.data == grown && view.data[3 * view.strides[0]] == at(2, 1, 3, 4), "slice buffer reuse");
+
+    auto slice = reader.read2DSliceFromMatrix("sliced", 4, 5);
+    check(slice.size() == 3 && slice[2].size() == 4 && slice[2][3] == at(2, 3, 4, 5), "2D slice");
+}
+
+void reductionRoundTrip(){
+    std::string directory = "C:/debug";
+    std::string file_prefix = "test";
+    const double inf = std::numeric_limits<double>::infinity();
+    std::string path;
+    {
+        auto h = H5FileWriter(directory, file_prefix);
+        hid_t matrix = h.generate4DMatrix("stats", 2, 3, 4, 5);
+        for (int n = 0; n < 120; n++) {
+            if (n % 11 == 0) continue; // Left as NaN
+            double value = n == 37 ? -inf : n == 90 ? inf : (n * 17 % 23) - 11.5;
+            h.writeTo4DMatrix(matrix, value, n / 60, n / 20 % 3, n / 5 % 4, n % 5);
+        }
+        h.generate4DMatrix("unwritten", 2, 2, 2, 2);
+        hid_t infinite = h.generate4DMatrix("infinite", 1, 1, 1, 2);
+        h.writeTo4DMatrix(infinite, inf, 0, 0, 0, 0);
+        h.writeTo4DMatrix(infinite, inf, 0, 0, 0, 1);
+        path = h.getFilePath();
+    }
+
+    // Reference from plain reads: min/max skip only NaN, sum and finite_count skip infinities too
+    std::vector<double> values = plainRead(path, "stats");
+    double sum = 0;
+    uint64_t finite = 0, nan = 0;
+    for (double value : values) {
+        if (std::isnan(value)) nan++;
+        if (std::isfinite(value)) { sum += value; finite++; }
+    }
+    H5FileReader reader(path);
+    for (size_t block_elements : {size_t(1) << 20, size_t(7)}) {
+        MatrixStatistics stats = reader.reduceMatrix("stats", block_elements);
+        check(stats.min == -inf && stats.argmin == std::vector<hsize_t>{0, 1, 3, 2}, "minimum and its coordinates");
+        check(stats.max == inf && stats.argmax == std::vector<hsize_t>{1, 1, 2, 0}, "maximum and its coordinates");
+        check(stats.nan_count == nan && stats.finite_count == finite && stats.sum == sum, "counts and sum");
+    }
+    check(reader.getMinimumFromMatrix("stats") == -inf, "minimum with infinities");
+    check(reader.getMinimumFromMatrix("unwritten") == std::numeric_limits<double>::max(), "minimum without values");
+    check(reader.getMinimumFromMatrix("infinite") == std::numeric_limits<double>::max(), "minimum without finite values");
+}
+
+void compressionRoundTrip(){
+    std::string directory = "C:/debug";
+    std::string file_prefix = "test";
+    MatrixOptions options;
+    options.compression_level = 4;
+    options.chunk_dims = {1, 2, 4, 4}; // Edges of axes 1 to 3 leave padded chunks
+    auto value = [](int i, int j, int k, int l) { return i * 1000.0 + j * 100.0 + k * 10.0 + l + 0.5; };
+    std::string path;
+    {
+        auto h = H5FileWriter(directory, file_prefix);
+        h.enableBufferedWrites();
+        hid_t matrix = h.generate4DMatrix("compressed", 2, 3, 5, 7, options);
+
+        // The first chunk reaches the file partially through the library, then completes
+        // as a whole chunk compressed by the writer itself
+        h.writeTo4DMatrix(matrix, -1.0, 0, 0, 0, 0);
+        h.flush();
+        for (int i = 0; i < 2; i++) {
+            for (int j = 0; j < 3; j++) {
+                for (int k = 0; k < 5; k++) {
+                    for (int l = 0; l < 7; l++) {
+                        if (i == 1 && j == 2 && k == 4 && l == 6) continue; // Left as fill value
+                        h.writeTo4DMatrix(matrix, value(i, j, k, l), i, j, k, l);
+                    }
+                }
+            }
+        }
+        path = h.getFilePath();
+    }
+
+    H5FileReader reader(path);
+    std::vector<double> values(2 * 3 * 5 * 7);
+    reader.readMatrix("compressed", values.data());
+    bool matches = true;
+    for (int i = 0; i < 2; i++) {
+        for (int j = 0; j < 3; j++) {
+            for (int k = 0; k < 5; k++) {
+                for (int l = 0; l < 7; l++) {
+                    double stored = values[((i * 3 + j) * 5 + k) * 7 + l];
+                    matches = matches && (i == 1 && j == 2 && k == 4 && l == 6 ? std::isnan(stored) : stored == value(i, j, k, l));
+                }
+            }
+        }
+    }
+    check(matches, "compressed matrix values");
+}
+
+void dictionaryRoundTrip(){
+    std::string directory = "C:/debug";
+    std::string file_prefix = "test";
+    std::map<std::string, double> values = {{"a", 1.0}, {"b", 2.5}};
+    std::string path;
+    {
+        auto h = H5FileWriter(directory, file_prefix);
+        h.writeDictionaryOfScalarsToDataset("params", values);
+        h.writeDictionaryOfScalarsToDataset("table", values, DictionaryStorage::Table);
+        // Shares the per-key prefix but is not part of the dictionary
+        h.writeMatrixAxisToDataset("params_axis", std::vector<double>(1000, 1.0));
+        path = h.getFilePath();
+    }
+
+    H5FileReader reader(path);
+    check(reader.readDictionaryFromDataset("params") == values, "per-key dictionary");
+    check(reader.readDictionaryFromDataset("table") == values, "dictionary table");
+    check(reader.readScalarFromDictionary("params", "b") == 2.5, "dictionary key");
+}
+
+void shardedRoundTrip(){
+    const int threads = 3;
+    std::string path = multiThreadedShardedWrite(threads);
+
+    // The master file reads as one matrix through its virtual dataset
+    H5FileReader reader(path);
+    check(reader.readScalarFromDataset("scalar") == 3.14, "master scalar");
+    check(reader.getMatrixDims("matrix") == std::vector<hsize_t>{3, 10, 10, 10}, "virtual matrix dims");
+    std::vector<double> values(threads * 1000);
+    reader.readMatrix("matrix", values.data());
+    bool matches = true;
+    for (int i = 0; i < threads; i++) {
+        for (int j = 0; j < 10; j++) {
+            for (int k = 0; k < 10; k++) {
+                for (int l = 0; l < 10; l++) {
+                    matches = matches && values[((i * 10 + j) * 10 + k) * 10 + l] == i + j + k + l;
+                }
+            }
+        }
+    }
+    check(matches, "virtual matrix values");
+}
+
+void matrixHandleRoundTrip(){
+    std::string directory = "C:/debug";
+    std::string file_prefix = "test";
+    std::string path;
+    {
+        auto h = H5FileWriter(directory, file_prefix);
+        auto grid = h.generateMatrix<3>("grid", {2, 3, 4});
+        auto counts = h.generateMatrix<2, int32_t>("counts", {3, 3});
+        for (int i = 0; i < 2; i++) {
+            for (int j = 0; j < 3; j++) {
+                for (int k = 0; k < 4; k++) {
+                    grid.write(i * 100 + j * 10 + k, i, j, k);
+                }
+            }
+        }
+        counts.write(-7, 2, 1);
+        check(grid.read(1, 2, 3) == 123.0, "writer handle read");
+        path = h.getFilePath();
+    }
+
+    H5FileReader reader(path);
+    auto grid = reader.openMatrix<3>("grid");
+    auto counts = reader.openMatrix<2, int32_t>("counts");
+    check(grid.dims() == Matrix<3>::Index{2, 3, 4}, "handle dims");
+    check(grid.read(0, 1, 2) == 12.0 && grid.read(1, 2, 3) == 123.0, "double handle");
+    check(counts.read(2, 1) == -7, "integer handle");
+    bool rejected = false;
+    try {
+        grid.read(2, 0, 0);
+    } catch (const std::out_of_range&) {
+        rejected = true;
+    }
+    check(rejected, "handle read out of bounds");
+}
+
+void directoryReaderRoundTrip(){
+    std::string directory = "C:/debug";
+    // A prefix of its own, files from earlier runs would join the stack
+    std::string file_prefix = "campaign" + std::to_string(std::random_device()());
+    const int files = 3;
+    for (int f = 0; f < files; f++) {
+        auto h = H5FileWriter(directory, file_prefix);
+        hid_t matrix = h.generate4DMatrix("matrix", 2, 2, 2, 2);
+        for (int n = 1; n < 16; n++) {
+            if (n == 1 && f == 0) continue; // Element 0 stays NaN everywhere, element 1 in one file
+            h.writeTo4DMatrix(matrix, (n * 7 + f * 13) % 10, n / 8, n / 4 % 2, n / 2 % 2, n % 2);
+        }
+    }
+
+    H5DirectoryReader campaign(directory, file_prefix);
+    check(campaign.size() == files, "campaign files");
+    StackedMatrix stacked = campaign.stackMatrices("matrix");
+    StackedMatrix maximum = campaign.maximumMatrix("matrix");
+    check(stacked.dims == std::vector<hsize_t>{3, 2, 2, 2, 2}, "stacked dims");
+    std::vector<double> expected_maximum(16, std::nan(""));
+    bool matches = true;
+    for (int f = 0; f < files; f++) {
+        std::vector<double> values = plainRead(campaign.files()[f], "matrix");
+        for (int n = 0; n < 16; n++) {
+            double stacked_value = stacked.values[f * 16 + n];
+            matches = matches && (std::isnan(values[n]) ? std::isnan(stacked_value) : stacked_value == values[n]);
+            if (!std::isnan(values[n]) && !(values[n] <= expected_maximum[n])) expected_maximum[n] = values[n];
+        }
+    }
+    check(matches, "stacked values");
+    check(std::isnan(maximum.values[0]), "maximum of NaN everywhere");
+    check(std::equal(expected_maximum.begin() + 1, expected_maximum.end(), maximum.values.begin() + 1), "maximum values");
+}
+
+void appendRoundTrip(){
+    std::string directory = "C:/debug";
+    std::string file_prefix = "test";
+    MatrixOptions options;
+    options.unlimited_axes = {0};
+    std::string path;
+    {
+        auto h = H5FileWriter(directory, file_prefix);
+        auto rows = h.generateMatrix<4>("rows", {0, 2, 2, 2}, options);
+        h.appendSlab(rows.id(), 0, std::vector<double>(16, 1.0));
+        check(rows.dims()[0] == 2, "handle extent after append");
+
+        // The handle follows the appended rows, writes past them fail despite the spare capacity
+        rows.write(9.0, 1, 1, 1, 1);
+        bool rejected = false;
+        try {
+            h.writeTo4DMatrix(rows.id(), 5.0, 2, 0, 0, 0);
+        } catch (const std::out_of_range&) {
+            rejected = true;
+        }
+        check(rejected, "write past the appended rows");
+        h.flush();
+        h.appendSlab(rows.id(), 0, std::vector<double>(8, 2.0));
+        rows.write(7.0, 2, 1, 1, 1);
+        path = h.getFilePath();
+    }
+
+    H5FileReader reader(path);
+    check(reader.getMatrixDims("rows") == std::vector<hsize_t>{3, 2, 2, 2}, "trimmed extent");
+    check(reader.readPointFromMatrix("rows", 1, 1, 1, 1) == 9.0, "handle write after append");
+    check(reader.readPointFromMatrix("rows", 2, 1, 1, 1) == 7.0, "handle write after trim");
+    check(reader.readPointFromMatrix("rows", 2, 0, 0, 0) == 2.0, "appended row");
+}
+
+void fileImageRoundTrip(){
+    std::string directory = "C:/debug";
+    std::string file_prefix = "test";
+    std::vector<double> axis = {0.5, 1.5, 2.5};
+    std::vector<unsigned char> image;
+    std::string persisted_path;
+    {
+        auto memory = H5FileWriter(directory, file_prefix, WriterStorage::Memory);
+        auto persisted = H5FileWriter(directory, file_prefix, WriterStorage::MemoryPersisted);
+        for (H5FileWriter* h : {&memory, &persisted}) {
+            h->writeMatrixAxisToDataset("axis", axis);
+            hid_t matrix = h->generate4DMatrix("matrix", 2, 2, 2, 3);
+            h->writeTo4DMatrix(matrix, 4.25, 1, 0, 1, 2);
+        }
+        image = memory.fileImage();
+        persisted_path = persisted.getFilePath();
+    }
+
+    // The plain library opens the same image through the core driver
+    hid_t fapl = H5Pcreate(H5P_FILE_ACCESS);
+    H5Pset_fapl_core(fapl, 64 << 10, 0);
+    H5Pset_file_image(fapl, image.data(), image.size());
+    std::vector<double> expected = plainRead("file image", "matrix", fapl);
+    H5Pclose(fapl);
+    check(expected[((1 * 2 + 0) * 2 + 1) * 3 + 2] == 4.25, "plain read of file image");
+
+    H5FileReader reader(std::move(image));
+    std::vector<double> values(expected.size());
+    reader.readMatrix("matrix", values.data());
+    bool matches = true;
+    for (size_t n = 0; n < values.size(); n++) {
+        matches = matches && (std::isnan(expected[n]) ? std::isnan(values[n]) : values[n] == expected[n]);
+    }
+    check(matches, "file image matrix");
+    check(reader.readMatrixAxisFromDataset("axis") == axis, "file image axis");
+    check(plainRead(persisted_path, "axis") == axis, "persisted axis");
+    check(plainRead(persisted_path, "matrix")[((1 * 2 + 0) * 2 + 1) * 3 + 2] == 4.25, "persisted matrix");
+}
+
+void interpolatorRoundTrip(){
+    // Uneven second axis, so both the stride and the bisection search run
+    std::vector<std::vector<double>> axes = {{0, 1, 2}, {0, 0.5, 2, 10}, {-2, -1, 0, 1, 2}, {0, 10, 20, 30, 40, 50}};
+    std::string path = writeSampleMatrix("grid", MatrixOptions(), axes);
+    std::vector<double> expected = plainRead(path, "grid");
+
+    H5FileReader reader(path);
+    H5Interpolator interpolator(reader, "grid", {"grid_axis0", "grid_axis1", "grid_axis2", "grid_axis3"});
+
+    // At the nodes the interpolation gives the stored values
+    std::vector<double> nodes;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 4; j++) {
+            for (int k = 0; k < 5; k++) {
+                for (int l = 0; l < 6; l++) {
+                    nodes.insert(nodes.end(), {axes[0][i], axes[1][j], axes[2][k], axes[3][l]});
+                }
+            }
+        }
+    }
+    check(interpolator.interpolate(nodes, expected.size()) == expected, "interpolation at nodes");
+
+    // Values are linear in the indices, so mid-cell queries land on fractional indices
+    check(interpolator.interpolate({1.5, 1.25, -0.5, 25}) == 1.5 * 1000 + 1.5 * 100 + 1.5 * 10 + 2.5, "interpolation in a cell");
+    check(std::isnan(interpolator.interpolate({0.5, 11, 0, 0})), "interpolation outside an axis");
+}
+
+void quantisationRoundTrip(){
+    std::string directory = "C:/debug";
+    std::string file_prefix = "test";
+    MatrixOptions options;
+    options.storage = StorageType::ScaledInt16;
+    options.scale = 0.1;
+    std::string path;
+    {
+        auto h = H5FileWriter(directory, file_prefix);
+        auto values = h.generateMatrix<4>("quantised", {1, 1, 1, 4}, options);
+        // Single values and batches must round the same way
+        values.write(0.35, 0, 0, 0, 0);
+        h.writeTo4DMatrix(values.id(), 0.35, 0, 0, 0, 1);
+        h.writePointsTo4DMatrix(values.id(), {0.35, std::nan("")}, {0, 0, 0, 2, 0, 0, 0, 3});
+        check(values.read(0, 0, 0, 0) == values.read(0, 0, 0, 1), "handle and writer encoding");
+        path = h.getFilePath();
+    }
+
+    H5FileReader reader(path);
+    std::vector<double> read = reader.readPointsFromMatrix("quantised", {0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 3});
+    check(std::fabs(read[0] - 0.3) < 1e-12, "quantised value");
+    check(read[1] == read[0] && read[2] == read[0], "quantised batch");
+    check(std::isnan(read[3]), "quantised NaN");
+}
+
 int main(void){
 
     // If I build with:
@@ -75,5 +582,50 @@ int main(void){
     //     minor: Unable to open file
     std::cout << "Multi threaded write complete" << std::endl;
 
+    multiThreadedServiceWrite(4);
+    std::cout << "Multi threaded service write complete" << std::endl;
+
+    multiThreadedShardedWrite(4);
+    std::cout << "Multi threaded sharded write complete" << std::endl;
+
+    reductionRoundTrip();
+    std::cout << "Reduction round trip complete" << std::endl;
+
+    sliceRoundTrip();
+    std::cout << "Slice round trip complete" << std::endl;
+
+    memoryMappingRoundTrip();
+    std::cout << "Memory mapping round trip complete" << std::endl;
+
+    compressionRoundTrip();
+    std::cout << "Compression round trip complete" << std::endl;
+
+    dictionaryRoundTrip();
+    std::cout << "Dictionary round trip complete" << std::endl;
+
+    shardedRoundTrip();
+    std::cout << "Sharded round trip complete" << std::endl;
+
+    matrixHandleRoundTrip();
+    std::cout << "Matrix handle round trip complete" << std::endl;
+
+    blockCacheRoundTrip();
+    std::cout << "Block cache round trip complete" << std::endl;
+
+    directoryReaderRoundTrip();
+    std::cout << "Directory reader round trip complete" << std::endl;
+
+    appendRoundTrip();
+    std::cout << "Append round trip complete" << std::endl;
+
+    fileImageRoundTrip();
+    std::cout << "File image round trip complete" << std::endl;
+
+    quantisationRoundTrip();
+    std::cout << "Quantisation round trip complete" << std::endl;
+
+    interpolatorRoundTrip();
+    std::cout << "Interpolator round trip complete" << std::endl;
+
     return 0;
 }
\ No newline at end of file
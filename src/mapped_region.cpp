@@ -0,0 +1,69 @@
+#include "mapped_region.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+MappedRegion::MappedRegion(const std::string& path, uint64_t offset, size_t length) : length(length) {
+    if (length == 0) {
+        throw std::invalid_argument("Cannot map an empty region of " + path);
+    }
+
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    uint64_t aligned = offset - offset % info.dwAllocationGranularity;
+    base_length = static_cast<size_t>(offset - aligned) + length;
+
+    file_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE) {
+        file_handle = nullptr;
+        throw std::runtime_error("Failed to open file for mapping: " + path);
+    }
+    mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_handle == nullptr) {
+        CloseHandle(file_handle);
+        throw std::runtime_error("Failed to create file mapping: " + path);
+    }
+    base = MapViewOfFile(mapping_handle, FILE_MAP_READ, static_cast<DWORD>(aligned >> 32), static_cast<DWORD>(aligned & 0xFFFFFFFF), base_length);
+    if (base == nullptr) {
+        CloseHandle(mapping_handle);
+        CloseHandle(file_handle);
+        throw std::runtime_error("Failed to map file: " + path);
+    }
+#else
+    uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    uint64_t aligned = offset - offset % page;
+    base_length = static_cast<size_t>(offset - aligned) + length;
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open file for mapping: " + path);
+    }
+    base = mmap(nullptr, base_length, PROT_READ, MAP_SHARED, fd, static_cast<off_t>(aligned));
+    close(fd); // The mapping keeps its own reference to the file
+    if (base == MAP_FAILED) {
+        base = nullptr;
+        throw std::runtime_error("Failed to map file: " + path);
+    }
+#endif
+
+    start = static_cast<const char*>(base) + (offset - aligned);
+}
+
+MappedRegion::~MappedRegion() {
+#ifdef _WIN32
+    UnmapViewOfFile(base);
+    CloseHandle(mapping_handle);
+    CloseHandle(file_handle);
+#else
+    munmap(base, base_length);
+#endif
+}
@@ -0,0 +1,33 @@
+#ifndef MAPPED_REGION_H
+#define MAPPED_REGION_H
+
+#include <cstdint>
+#include <string>
+
+
+// Read-only memory mapping of a byte range of a file
+class MappedRegion {
+
+    public:
+
+        MappedRegion(const std::string& path, uint64_t offset, size_t length);
+        ~MappedRegion();
+
+        MappedRegion(const MappedRegion&) = delete;
+        MappedRegion& operator=(const MappedRegion&) = delete;
+
+        const void* data() const { return start; }
+        size_t size() const { return length; }
+
+    protected:
+        void* base = nullptr;      // Start of the mapping, aligned down to the mapping granularity
+        size_t base_length = 0;
+        const char* start = nullptr;
+        size_t length = 0;
+#ifdef _WIN32
+        void* file_handle = nullptr;
+        void* mapping_handle = nullptr;
+#endif
+};
+
+#endif // MAPPED_REGION_H
@@ -0,0 +1,92 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// Fixed set of worker threads draining a FIFO of tasks
+class ThreadPool {
+
+    public:
+
+        explicit ThreadPool(size_t threads = std::thread::hardware_concurrency()) {
+            if (threads == 0) threads = 1;
+            for (size_t n = 0; n < threads; ++n) {
+                workers.emplace_back([this]() { work(); });
+            }
+        }
+
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            available.notify_all();
+            for (auto& worker : workers) {
+                worker.join();
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // Process-wide pool sized to the machine, for CPU-bound work
+        static ThreadPool& shared() {
+            static ThreadPool pool;
+            return pool;
+        }
+
+        size_t size() const { return workers.size(); }
+
+        // True on one of this pool's workers, where waiting on the pool's own tasks can deadlock
+        bool onWorkerThread() const { return current() == this; }
+
+        template <typename F>
+        auto submit(F&& task) -> std::future<decltype(task())> {
+            using Result = decltype(task());
+            auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+            std::future<Result> result = packaged->get_future();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                tasks.emplace_back([packaged]() { (*packaged)(); });
+            }
+            available.notify_one();
+            return result;
+        }
+
+    protected:
+        static const ThreadPool*& current() {
+            thread_local const ThreadPool* pool = nullptr;
+            return pool;
+        }
+
+        void work() {
+            current() = this;
+            for (;;) {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    available.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                    if (tasks.empty()) return;
+                    task = std::move(tasks.front());
+                    tasks.pop_front();
+                }
+                task();
+            }
+        }
+
+        std::vector<std::thread> workers;
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+        std::condition_variable available;
+        bool stopping = false;
+};
+
+#endif // THREAD_POOL_H
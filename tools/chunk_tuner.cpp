@@ -0,0 +1,88 @@
+#include "h5_chunk_tuner.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// Replays a recorded access trace against every candidate chunk shape and
+// reports the layouts that load the fewest chunk bytes.
+//
+// Usage: hdf5_multithread_test_chunk_tuner <trace> [--cache-bytes <bytes>] [--max-chunk-elements <n>] [--top <n>]
+//
+// See AccessTrace::load for the trace format.
+
+namespace {
+
+// Digits only: std::stoul would take "-1" as a huge count and "12abc" as 12
+size_t parseCount(const std::string& flag, const std::string& text) {
+    if (text.empty() || !std::all_of(text.begin(), text.end(), [](unsigned char c) { return std::isdigit(c); })) {
+        throw std::invalid_argument("Expected a non-negative integer for " + flag + ": " + text);
+    }
+    try {
+        return std::stoul(text);
+    } catch (const std::out_of_range&) {
+        throw std::invalid_argument("Value out of range for " + flag + ": " + text);
+    }
+}
+
+}
+
+int main(int argc, char** argv) {
+    const std::string usage = std::string("Usage: ") + argv[0] + " <trace> [--cache-bytes <bytes>] [--max-chunk-elements <n>] [--top <n>]";
+    if (argc < 2) {
+        std::cerr << usage << std::endl;
+        return 1;
+    }
+
+    size_t cache_bytes = 1 << 20; // HDF5 default chunk cache
+    size_t max_chunk_elements = ChunkTuner::default_max_chunk_elements;
+    size_t top = 10;
+    try {
+        for (int n = 2; n < argc; n += 2) {
+            std::string flag = argv[n];
+            if (n + 1 == argc) {
+                throw std::invalid_argument("Missing value for " + flag);
+            }
+            size_t value = parseCount(flag, argv[n + 1]);
+            if (flag == "--cache-bytes") {
+                cache_bytes = value;
+            } else if (flag == "--max-chunk-elements") {
+                max_chunk_elements = value;
+            } else if (flag == "--top") {
+                top = value;
+            } else {
+                throw std::invalid_argument("Unknown argument: " + flag);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << usage << std::endl;
+        return 1;
+    }
+
+    std::ifstream in(argv[1]);
+    if (!in) {
+        std::cerr << "Failed to open trace: " << argv[1] << std::endl;
+        return 1;
+    }
+
+    try {
+        AccessTrace trace = AccessTrace::load(in);
+        std::vector<ChunkLayout> layouts = ChunkTuner::rank(trace, cache_bytes, max_chunk_elements);
+        std::cout << trace.accesses.size() << " accesses, " << layouts.size() << " candidate layouts, "
+                  << cache_bytes << " byte chunk cache" << std::endl;
+        for (size_t n = 0; n < layouts.size() && n < top; ++n) {
+            std::cout << (n == 0 ? "best " : "     ") << "chunk";
+            for (size_t d = 0; d < layouts[n].chunk.size(); ++d) {
+                std::cout << (d == 0 ? " " : "x") << layouts[n].chunk[d];
+            }
+            std::cout << "  cost " << layouts[n].cost << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to tune " << argv[1] << ": " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}